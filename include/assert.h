@@ -20,7 +20,7 @@
 #else
 
 #define debug_assert(expression)
-#define breakpoint()
+#define breakpoint(...)
 
 #endif
 
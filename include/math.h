@@ -282,6 +282,37 @@ v2_perp(v2 a)
   return (v2){.x = -a.y, .y = a.x};
 }
 
+/*
+ * Rotates counter clockwise around origin.
+ *   x' = x cos θ - y sin θ
+ *   y' = x sin θ + y cos θ
+ * @param angle θ, unit: rad
+ */
+static inline v2
+v2_rotate(v2 a, f32 angle)
+{
+  f32 c = Cos(angle);
+  f32 s = Sin(angle);
+  return (v2){.x = a.x * c - a.y * s, .y = a.x * s + a.y * c};
+}
+
+/* Rotates clockwise around origin, undoes v2_rotate() */
+static inline v2
+v2_rotate_inverse(v2 a, f32 angle)
+{
+  return v2_rotate(a, -angle);
+}
+
+/*
+ * 2D cross product, z component of 3D cross product of a and b on xy plane.
+ *   a × b = aₓb_y - a_yb_x
+ */
+static inline f32
+v2_cross(v2 a, v2 b)
+{
+  return a.x * b.y - a.y * b.x;
+}
+
 static inline f32
 v2_length_square(v2 a)
 {
@@ -330,6 +361,42 @@ v2_neg(v2 a)
   return a;
 }
 
+/*
+ * 2x2 matrix, stored as columns.
+ */
+typedef struct m2 {
+  v2 x; // first column
+  v2 y; // second column
+} m2;
+
+/*
+ * Counter clockwise rotation, see: v2_rotate()
+ *   R = │cos θ  -sin θ│
+ *       │sin θ   cos θ│
+ * @param angle θ, unit: rad
+ */
+static inline m2
+m2_rotation(f32 angle)
+{
+  f32 c = Cos(angle);
+  f32 s = Sin(angle);
+  return (m2){.x = {c, s}, .y = {-s, c}};
+}
+
+/* M a */
+static inline v2
+m2_mul_v2(m2 m, v2 a)
+{
+  return (v2){.x = m.x.x * a.x + m.y.x * a.y, .y = m.x.y * a.x + m.y.y * a.y};
+}
+
+/* Mᵀ a, which is inverse for rotation matrix */
+static inline v2
+m2_mul_transpose_v2(m2 m, v2 a)
+{
+  return (v2){.x = v2_dot(m.x, a), .y = v2_dot(m.y, a)};
+}
+
 typedef struct v3 {
   union {
     struct {
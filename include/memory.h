@@ -20,6 +20,15 @@ struct memory_arena {
   u8 *block;
   u64 used;
   u64 total;
+#if IS_BUILD_DEBUG
+  /* Instrumentation for sizing memory budgets.
+   * see: StringBuilderAppendMemoryArena()
+   */
+  const char *name; // zero terminated, optional
+  u64 peak;         // high-water mark of used
+  u64 pushCount;    // number of pushes made into arena
+  u64 wasted;       // bytes lost to padding in MemoryArenaPushAligned()
+#endif
 };
 
 typedef struct memory_arena memory_arena;
@@ -31,17 +40,45 @@ struct memory_temp {
 
 typedef struct memory_temp memory_temp;
 
+static inline void
+MemoryArenaTrack(memory_arena *mem, u64 wasted)
+{
+#if IS_BUILD_DEBUG
+  mem->pushCount++;
+  mem->wasted += wasted;
+  if (mem->used > mem->peak)
+    mem->peak = mem->used;
+#endif
+}
+
+/*
+ * @param name used only for instrumentation, can be 0
+ */
+static memory_arena
+MemoryArena(void *block, u64 total, const char *name)
+{
+  memory_arena arena = (struct memory_arena){
+      .total = total,
+      .block = block,
+#if IS_BUILD_DEBUG
+      .name = name,
+#endif
+  };
+  return arena;
+}
+
+/*
+ * @param name used only for instrumentation, can be 0
+ */
 static memory_arena
-MemoryArenaSub(memory_arena *master, u64 size)
+MemoryArenaSub(memory_arena *master, u64 size, const char *name)
 {
   debug_assert(master->used + size <= master->total);
 
-  memory_arena sub = (struct memory_arena){
-      .total = size,
-      .block = master->block + master->used,
-  };
+  memory_arena sub = MemoryArena(master->block + master->used, size, name);
 
   master->used += size;
+  MemoryArenaTrack(master, 0);
   return sub;
 }
 
@@ -51,6 +88,7 @@ MemoryArenaPush(memory_arena *mem, u64 size)
   debug_assert(mem->used + size <= mem->total);
   u8 *result = mem->block + mem->used;
   mem->used += size;
+  MemoryArenaTrack(mem, 0);
   return result;
 }
 
@@ -63,15 +101,17 @@ MemoryArenaPushAligned(memory_arena *mem, u64 size, u64 alignment)
 
   u64 alignmentMask = alignment - 1;
   u64 alignmentResult = ((u64)block & alignmentMask);
+  u64 alignmentOffset = 0;
   if (alignmentResult != 0) {
     // if it is not aligned
-    u64 alignmentOffset = alignment - alignmentResult;
+    alignmentOffset = alignment - alignmentResult;
     size += alignmentOffset;
     block += alignmentOffset;
   }
 
   debug_assert(mem->used + size <= mem->total);
   mem->used += size;
+  MemoryArenaTrack(mem, alignmentOffset);
 
   return block;
 }
@@ -93,3 +133,191 @@ MemoryTempEnd(memory_temp *tempMemory)
 }
 
 #define __cleanup_memory_temp__ __attribute__((cleanup(MemoryTempEnd)))
+
+/*
+ * Scratch arenas are for temporary memory within a function call. Every
+ * thread owns its own set, so threads never share a scratch arena and
+ * MemoryTempBegin/MemoryTempEnd stay valid without locks.
+ *
+ * A function may receive an arena for its result that is itself one of the
+ * caller's scratch arenas. Pass such arenas as conflicts, so pushing
+ * temporary memory does not interleave with, or free, the result.
+ *
+ * @code
+ *   memory_arena *conflicts[] = {resultArena};
+ *   __cleanup_memory_temp__ memory_temp scratch =
+ *       MemoryScratchBegin(threadScratches, MEMORY_SCRATCH_PER_THREAD, conflicts, ARRAY_COUNT(conflicts));
+ * @endcode
+ */
+#define MEMORY_SCRATCH_PER_THREAD 2
+
+static memory_temp
+MemoryScratchBegin(memory_arena *scratches, u32 scratchCount, memory_arena **conflicts, u32 conflictCount)
+{
+  debug_assert(conflictCount < scratchCount && "not enough scratch arenas to avoid conflicts");
+
+  for (u32 scratchIndex = 0; scratchIndex < scratchCount; scratchIndex++) {
+    memory_arena *scratch = scratches + scratchIndex;
+
+    b8 isConflicting = 0;
+    for (u32 conflictIndex = 0; conflictIndex < conflictCount; conflictIndex++) {
+      if (conflicts[conflictIndex] == scratch) {
+        isConflicting = 1;
+        break;
+      }
+    }
+
+    if (!isConflicting)
+      return MemoryTempBegin(scratch);
+  }
+
+  breakpoint("all scratch arenas are conflicting");
+  return MemoryTempBegin(scratches);
+}
+
+/*
+ * Fixed-size block pool layered on top of arena.
+ *
+ * Blocks are carved from arena in chunks and recycled through an intrusive
+ * free list, so allocating and freeing is O(1) and memory given back to pool
+ * is reused by next allocation instead of being lost in arena.
+ *
+ * Block stride is rounded up to power of two when smaller than cache line, or
+ * to multiple of cache line otherwise. Together with chunks being cache line
+ * aligned, a block never straddles two cache lines.
+ *
+ * In debug builds freed blocks are filled with MEMORY_POOL_POISON and checked
+ * on next allocation to catch writes after free.
+ *
+ * @code
+ *   memory_pool pool = MemoryPoolOf(arena, struct contact, 64);
+ *   struct contact *contact = MemoryPoolAllocType(&pool, struct contact);
+ *   MemoryPoolFree(&pool, contact);
+ * @endcode
+ */
+#define CACHE_LINE_SIZE 64
+#define MEMORY_POOL_POISON 0xdd
+
+struct memory_pool_block {
+  struct memory_pool_block *next;
+};
+
+struct memory_pool {
+  memory_arena *arena;
+  struct memory_pool_block *free; // intrusive free list
+  u64 blockSize;                  // stride of each block in bytes
+  u32 blocksPerChunk;             // blocks carved from arena at once
+  u32 used;                       // blocks handed out
+  u32 total;                      // blocks carved from arena
+};
+
+typedef struct memory_pool memory_pool;
+
+static memory_pool
+MemoryPool(memory_arena *arena, u64 size, u32 blocksPerChunk)
+{
+  debug_assert(size > 0);
+  debug_assert(blocksPerChunk > 0);
+
+  if (size < sizeof(struct memory_pool_block))
+    size = sizeof(struct memory_pool_block);
+
+  u64 blockSize;
+  if (size < CACHE_LINE_SIZE) {
+    // next power of two
+    blockSize = sizeof(struct memory_pool_block);
+    while (blockSize < size)
+      blockSize <<= 1;
+  } else {
+    blockSize = (size + (CACHE_LINE_SIZE - 1)) & ~(u64)(CACHE_LINE_SIZE - 1);
+  }
+
+  return (memory_pool){
+      .arena = arena,
+      .blockSize = blockSize,
+      .blocksPerChunk = blocksPerChunk,
+  };
+}
+
+#define MemoryPoolOf(arena, type, blocksPerChunk) MemoryPool(arena, sizeof(type), blocksPerChunk)
+
+static inline void
+MemoryPoolPoison(memory_pool *pool, struct memory_pool_block *block)
+{
+#if IS_BUILD_DEBUG
+  u8 *bytes = (u8 *)block;
+  for (u64 byteIndex = sizeof(*block); byteIndex < pool->blockSize; byteIndex++)
+    bytes[byteIndex] = MEMORY_POOL_POISON;
+#endif
+}
+
+static inline b8
+IsMemoryPoolPoisoned(memory_pool *pool, struct memory_pool_block *block)
+{
+#if IS_BUILD_DEBUG
+  u8 *bytes = (u8 *)block;
+  for (u64 byteIndex = sizeof(*block); byteIndex < pool->blockSize; byteIndex++) {
+    if (bytes[byteIndex] != MEMORY_POOL_POISON)
+      return 0;
+  }
+#endif
+  return 1;
+}
+
+static void
+MemoryPoolGrow(memory_pool *pool)
+{
+  u8 *chunk = MemoryArenaPushAligned(pool->arena, pool->blockSize * pool->blocksPerChunk, CACHE_LINE_SIZE);
+
+  // link in reverse, so blocks are handed out in address order
+  for (u32 blockIndex = pool->blocksPerChunk; blockIndex > 0; blockIndex--) {
+    struct memory_pool_block *block = (struct memory_pool_block *)(chunk + pool->blockSize * (blockIndex - 1));
+    MemoryPoolPoison(pool, block);
+    block->next = pool->free;
+    pool->free = block;
+  }
+
+  pool->total += pool->blocksPerChunk;
+}
+
+/*
+ * @return zeroed block of pool->blockSize bytes
+ * Time Complexity: O(1)
+ */
+static void *
+MemoryPoolAlloc(memory_pool *pool)
+{
+  if (!pool->free)
+    MemoryPoolGrow(pool);
+
+  struct memory_pool_block *block = pool->free;
+  debug_assert(IsMemoryPoolPoisoned(pool, block) && "block modified after free");
+  pool->free = block->next;
+  pool->used++;
+
+  bzero(block, pool->blockSize);
+  return block;
+}
+
+#define MemoryPoolAllocType(pool, type) ((type *)MemoryPoolAlloc(pool))
+
+/*
+ * Gives block back to pool. Block must be allocated from same pool.
+ * Time Complexity: O(1)
+ */
+static void
+MemoryPoolFree(memory_pool *pool, void *memory)
+{
+  debug_assert(memory != 0);
+#if IS_BUILD_DEBUG
+  u64 blockAlignment = pool->blockSize < CACHE_LINE_SIZE ? pool->blockSize : CACHE_LINE_SIZE;
+  debug_assert(((u64)memory & (blockAlignment - 1)) == 0 && "not a block of pool");
+#endif
+  debug_assert(pool->used > 0);
+
+  struct memory_pool_block *block = memory;
+  MemoryPoolPoison(pool, block);
+  block->next = pool->free;
+  pool->free = block;
+  pool->used--;
+}
@@ -237,6 +237,38 @@ StringBuilderAppendHexDump(string_builder *sb, struct string *string)
   }
 }
 
+#if IS_BUILD_DEBUG
+/*
+ * Appends usage of arena in single line.
+ *
+ * @code
+ *   world used: 1024/8388608 (0.01%) peak: 2048 pushes: 12 wasted: 24
+ * @endcode
+ */
+static void
+StringBuilderAppendMemoryArena(string_builder *sb, memory_arena *arena)
+{
+  if (arena->name)
+    StringBuilderAppendZeroTerminated(sb, arena->name, 32);
+  else
+    StringBuilderAppendStringLiteral(sb, "arena");
+
+  StringBuilderAppendStringLiteral(sb, " used: ");
+  StringBuilderAppendU64(sb, arena->used);
+  StringBuilderAppendStringLiteral(sb, "/");
+  StringBuilderAppendU64(sb, arena->total);
+  StringBuilderAppendStringLiteral(sb, " (");
+  f32 usage = arena->total == 0 ? 0.0f : (f32)arena->used / (f32)arena->total * 100.0f;
+  StringBuilderAppendF32(sb, usage, 2);
+  StringBuilderAppendStringLiteral(sb, "%) peak: ");
+  StringBuilderAppendU64(sb, arena->peak);
+  StringBuilderAppendStringLiteral(sb, " pushes: ");
+  StringBuilderAppendU64(sb, arena->pushCount);
+  StringBuilderAppendStringLiteral(sb, " wasted: ");
+  StringBuilderAppendU64(sb, arena->wasted);
+}
+#endif
+
 /*
  * Returns string that is ready for transmit.
  * Also resets length of builder.
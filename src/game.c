@@ -14,12 +14,16 @@ static struct entity *
 EntityAdd(game_state *state, v2 position, f32 mass, volume *volume, v4 color)
 {
   debug_assert(mass >= 0.0f && "entity max cannot be negative");
+  // registry returns 0 when it is full, in every build
+  runtime_assert(volume && "no volume, is volume registry full?");
   u32 entityIndex = state->entityCount;
   debug_assert(entityIndex < state->entityMax && "max entity count reached");
   entity *entity = state->entities + entityIndex;
 
   // simulation parameters
   entity->position = position;
+  EntityUpdateRotation(entity);
+  entity->sweepPosition = position;
 
   entity->volume = volume;
   if (mass != ENTITY_STATIC_MASS) {
@@ -29,6 +33,7 @@ EntityAdd(game_state *state, v2 position, f32 mass, volume *volume, v4 color)
     entity->invI = Inverse(entity->I);
   }
   entity->restitution = 1.0f;
+  entity->filter = COLLISION_FILTER_DEFAULT;
 
   // visual parameters
   entity->color = color;
@@ -37,6 +42,421 @@ EntityAdd(game_state *state, v2 position, f32 mass, volume *volume, v4 color)
   return entity;
 }
 
+/*
+ * Begins temporary memory on scratch arena of calling thread, that is not
+ * one of conflicts.
+ * see: MemoryScratchBegin()
+ */
+static memory_temp
+ScratchBegin(transient_state *transientState, u32 threadIndex, memory_arena **conflicts, u32 conflictCount)
+{
+  debug_assert(threadIndex < PLATFORM_THREAD_MAX);
+  memory_arena *scratches = transientState->scratchArenas[threadIndex];
+  return MemoryScratchBegin(scratches, MEMORY_SCRATCH_PER_THREAD, conflicts, conflictCount);
+}
+
+/*
+ * Per-entity passes run on job system. Each pass only touches entity at given
+ * index, so entity range can be split across threads freely.
+ * see: PlatformParallelFor()
+ */
+#define ENTITY_PASS_BATCH_SIZE 32
+
+struct entity_pass {
+  game_state *state;
+  v2 inputForce;
+  f32 dt;
+};
+
+static void
+EntityApplyForcesJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct entity_pass *pass = data;
+  // entity index 0 is null entity, job indexes are offset by one
+  for (u32 entityIndex = startIndex + 1; entityIndex < endIndex + 1; entityIndex++) {
+    struct entity *entity = pass->state->entities + entityIndex;
+
+    if (IsEntityStatic(entity))
+      continue;
+
+    // clear forces from last frame
+    entity->netForce = (v2){0.0f, 0.0f};
+    entity->netTorque = 0.0f;
+
+    // apply input force
+    v2_add_ref(&entity->netForce, v2_scale(pass->inputForce, 30.0f));
+
+    // apply drag force
+    v2 dragForce = GenerateDragForce(entity, 3.81f);
+    v2_add_ref(&entity->netForce, dragForce);
+
+#if 0
+    // apply weight force
+    v2 weightForce = GenerateWeightForce(entity);
+    v2_add_ref(&entity->netForce, weightForce);
+
+    // do not apply any force
+    entity->netForce = V2(0.0f, 0.0f);
+    entity->netTorque = 0.0f;
+#endif
+  }
+}
+
+static void
+EntityIntegrateJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct entity_pass *pass = data;
+  f32 dt = pass->dt;
+  for (u32 entityIndex = startIndex + 1; entityIndex < endIndex + 1; entityIndex++) {
+    struct entity *entity = pass->state->entities + entityIndex;
+
+    // entities that do not move this step sweep in place
+    entity->sweepPosition = entity->position;
+    entity->sweepRotation = entity->rotation;
+
+    if (!IsEntityAwake(entity))
+      continue;
+
+    /* LINEAR KINEMATICS
+     *
+     * The rate at which "position" p changes is called "velocity" v.
+     *   v = ∆p/∆t
+     *
+     * The rate at which v changes is called "acceleration" a.
+     *   a = ∆v/∆t
+     *
+     * a = f''(t)
+     * v = ∫f''(t)
+     *   = f'(t)
+     *   = at + v₀
+     * p = ∫f'(t)
+     *   = f(t)
+     *   = ½at² + vt + p₀
+     *
+     * Newton's Law of motion
+     *   F = ma
+     *   where F is force,
+     *         m is mass,
+     *         a is acceleration.
+     *
+     * a = F/m
+     */
+
+    // a = F/m
+    entity->acceleration = v2_scale(entity->netForce, entity->invMass);
+
+    // v = at + v₀
+    v2_add_ref(&entity->velocity, v2_scale(entity->acceleration, dt));
+
+    // p = ½at² + vt + p₀
+    v2_add_ref(&entity->position, v2_add(
+                                      // ½at²
+                                      v2_scale(entity->acceleration, 0.5f * Square(dt)),
+                                      // + vt
+                                      v2_scale(entity->velocity, dt)));
+
+    /* ANGULAR KINEMATICS
+     *
+     * As the body rotates, "angle" θ will change. The rate at which θ changes
+     * is called "angular velocity", ω.
+     *   ω = ∆θ/∆t
+     *
+     * Likewise as body rotates, the rate at which ω changes is called "angular
+     * acceleration", α.
+     *   α = ∆ω/∆t
+     *
+     * α = f''(t)
+     * ω = ∫f''(t)
+     *   = f'(t)
+     *   = αt + ω₀
+     * θ = ∫f'(t)
+     *   = ½αt² + ωt + θ₀
+     *
+     * Angular motion analogous to linear motion.
+     *   τ = I α
+     *   where τ is torque,
+     *           Rotational motion.
+     *         I is moment of inertia.
+     *           Measures how much an object "resists" to change its angular
+     *           acceleration.
+     *           a.k.a. angular mass
+     *           unit: kg m²
+     *
+     * α = τ/I
+     */
+
+    // α = τ/I
+    entity->angularAcceleration = entity->netTorque * entity->invI;
+    // ω = αt + ω₀
+    entity->angularVelocity += entity->angularAcceleration * dt;
+    // θ  = ½αt² + ωt + θ₀
+    entity->rotation += 0.5f * entity->angularAcceleration * Square(dt) + entity->angularVelocity * dt;
+    // once per step, support functions in narrowphase reuse it
+    EntityUpdateRotation(entity);
+  }
+}
+
+static void
+EntityTimeOfImpactJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct entity_pass *pass = data;
+  game_state *state = pass->state;
+  for (u32 entityIndex = startIndex + 1; entityIndex < endIndex + 1; entityIndex++) {
+    struct entity *entity = state->entities + entityIndex;
+    if (!entity->isBullet)
+      continue;
+
+    EntitySolveTimeOfImpact(state->entities, state->entityCount, &state->terrain, entityIndex, state->solverConfig.slop);
+  }
+}
+
+/*
+ * Narrowphase output of one thread. Threads claim pair batches in increasing
+ * order, so collisions of each output are already sorted by pair index.
+ */
+struct narrowphase_output {
+  collision *collisions;
+  u32 collisionCount;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+#define NARROWPHASE_BATCH_SIZE 16
+
+struct narrowphase_job {
+  entity *entities;
+  collision_pair *pairs;
+  circle_pack circles;
+  u32 circlePairCount; // circle-circle pairs come first, see: BroadphaseBucketPairs()
+  struct narrowphase_output outputs[PLATFORM_THREAD_MAX];
+};
+
+static void
+NarrowphaseJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct narrowphase_job *job = data;
+  debug_assert(threadIndex < PLATFORM_THREAD_MAX);
+  struct narrowphase_output *output = job->outputs + threadIndex;
+
+  // batch may straddle end of circle-circle bucket
+  u32 circleEndIndex = Minimum(endIndex, Maximum(startIndex, job->circlePairCount));
+  output->collisionCount += NarrowphaseCircles(&job->circles, job->pairs, startIndex, circleEndIndex,
+                                               output->collisions + output->collisionCount);
+  output->collisionCount += Narrowphase(job->entities, job->pairs, circleEndIndex, endIndex,
+                                        output->collisions + output->collisionCount);
+}
+
+struct terrain_narrowphase_job {
+  terrain *terrain;
+  entity *entities;
+  terrain_pair *pairs;
+  struct narrowphase_output outputs[PLATFORM_THREAD_MAX];
+};
+
+static void
+TerrainNarrowphaseJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct terrain_narrowphase_job *job = data;
+  debug_assert(threadIndex < PLATFORM_THREAD_MAX);
+  struct narrowphase_output *output = job->outputs + threadIndex;
+  output->collisionCount += TerrainNarrowphase(job->terrain, job->entities, job->pairs, startIndex, endIndex,
+                                               output->collisions + output->collisionCount);
+}
+
+/*
+ * Any thread may claim every batch, so each thread gets room for every pair.
+ * Manifolds make that too large for scratch arenas, outputs are taken from
+ * memory instead and released by MemoryTempEnd() after merge.
+ */
+static memory_temp
+NarrowphaseOutputsBegin(memory_arena *memory, struct narrowphase_output *outputs, u32 threadCount, u32 pairCount)
+{
+  memory_temp outputMemory = MemoryTempBegin(memory);
+  u64 outputSize = sizeof(*outputs->collisions) * pairCount;
+  // arena checks only in debug builds, overflow would overwrite memory after it
+  runtime_assert(memory->used + outputSize * threadCount <= memory->total && "no memory for narrowphase outputs");
+  for (u32 threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+    struct narrowphase_output *output = outputs + threadIndex;
+    output->collisions = MemoryArenaPush(memory, outputSize);
+  }
+  return outputMemory;
+}
+
+/*
+ * Merges outputs of all threads in pair order, so result does not depend on
+ * how batches were distributed between threads.
+ * @return number of collisions written
+ */
+static u32
+NarrowphaseMerge(struct narrowphase_output *outputs, u32 threadCount, collision *collisions)
+{
+  u32 heads[PLATFORM_THREAD_MAX] = {};
+  u32 collisionCount = 0;
+  while (1) {
+    u32 minThreadIndex = threadCount;
+    u32 minPairIndex = U32_MAX;
+    for (u32 threadIndex = 0; threadIndex < threadCount; threadIndex++) {
+      struct narrowphase_output *output = outputs + threadIndex;
+      if (heads[threadIndex] == output->collisionCount)
+        continue;
+
+      u32 pairIndex = output->collisions[heads[threadIndex]].pairIndex;
+      if (pairIndex < minPairIndex) {
+        minPairIndex = pairIndex;
+        minThreadIndex = threadIndex;
+      }
+    }
+
+    if (minThreadIndex == threadCount)
+      break;
+
+    struct narrowphase_output *output = outputs + minThreadIndex;
+    collisions[collisionCount] = output->collisions[heads[minThreadIndex]];
+    heads[minThreadIndex]++;
+    collisionCount++;
+  }
+
+  return collisionCount;
+}
+
+#define SOLVER_BATCH_SIZE 16
+
+struct solver_job {
+  entity *entities;
+  solver_config *config;
+  collision *collisions;
+  contact_constraint *constraints;
+};
+
+static void
+SolverPrepareJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct solver_job *job = data;
+  SolverPrepare(job->constraints, job->collisions, startIndex, endIndex, job->entities, job->config);
+}
+
+static void
+SolverVelocityJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct solver_job *job = data;
+  SolverSolveVelocity(job->constraints, startIndex, endIndex, job->entities);
+}
+
+static void
+SolverPositionJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct solver_job *job = data;
+  SolverSolvePosition(job->constraints, startIndex, endIndex, job->entities, job->config);
+}
+
+static void
+SolverWarmStartJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct solver_job *job = data;
+  SolverWarmStart(job->constraints, startIndex, endIndex, job->entities);
+}
+
+static void
+SolverStoreImpulsesJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct solver_job *job = data;
+  SolverStoreImpulses(job->constraints, startIndex, endIndex);
+}
+
+/*
+ * Runs one solver pass over constraints of one color.
+ * see: CollisionColor()
+ */
+static void
+SolverColorParallelFor(platform_job_system *jobSystem, struct solver_job *job, u32 *colorOffsets, u32 color,
+                       pfnPlatformParallelForJob pass)
+{
+  u32 colorStart = colorOffsets[color];
+  u32 colorConstraintCount = colorOffsets[color + 1] - colorStart;
+  struct solver_job colorJob = *job;
+  colorJob.collisions += colorStart;
+  colorJob.constraints += colorStart;
+
+  if (color == COLLISION_COLOR_OVERFLOW) {
+    // overflow constraints may share entities
+    pass(&colorJob, 0, colorConstraintCount, 0);
+  } else {
+    PlatformParallelFor(jobSystem, colorConstraintCount, SOLVER_BATCH_SIZE, pass, &colorJob);
+  }
+}
+
+/*
+ * Solves constraints grouped by color. Every iteration walks colors one after
+ * another, constraints of one color in parallel.
+ */
+static void
+SolverSolveColored(platform_job_system *jobSystem, struct solver_job *job, u32 colorCount, u32 *colorOffsets)
+{
+  for (u32 color = 0; color < colorCount; color++)
+    SolverColorParallelFor(jobSystem, job, colorOffsets, color, SolverWarmStartJob);
+
+  for (u32 iteration = 0; iteration < job->config->velocityIterations; iteration++) {
+    for (u32 color = 0; color < colorCount; color++)
+      SolverColorParallelFor(jobSystem, job, colorOffsets, color, SolverVelocityJob);
+  }
+
+  for (u32 iteration = 0; iteration < job->config->positionIterations; iteration++) {
+    for (u32 color = 0; color < colorCount; color++)
+      SolverColorParallelFor(jobSystem, job, colorOffsets, color, SolverPositionJob);
+  }
+
+  // every constraint owns its cache entry
+  u32 constraintCount = colorOffsets[colorCount];
+  PlatformParallelFor(jobSystem, constraintCount, SOLVER_BATCH_SIZE, SolverStoreImpulsesJob, job);
+}
+
+/*
+ * Islands with fewer collisions are not worth coloring, whole island is
+ * solved serially on one thread instead.
+ * see: IslandBuild()
+ */
+#define ISLAND_COLOR_THRESHOLD 64
+#define ISLAND_SOLVE_BATCH_SIZE 4
+
+struct island_coloring {
+  u32 islandIndex;
+  u32 colorCount;
+  u32 colorOffsets[COLLISION_COLOR_MAX + 1]; // relative to first collision of island
+};
+
+struct island_solve_job {
+  struct solver_job *solver;
+  island_list *islandList;
+  u32 *islandIndices;
+};
+
+static void
+IslandSolveJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct island_solve_job *job = data;
+  struct solver_job *solver = job->solver;
+  for (u32 index = startIndex; index < endIndex; index++) {
+    island *island = job->islandList->islands + job->islandIndices[index];
+    SolverSolve(solver->config, solver->constraints + island->collisionOffset, island->collisionCount,
+                solver->entities);
+  }
+}
+
+#define ISLAND_SLEEP_BATCH_SIZE 16
+
+struct island_sleep_job {
+  entity *entities;
+  island_list *islandList;
+  f32 dt;
+};
+
+static void
+IslandSleepJob(void *data, u32 startIndex, u32 endIndex, u32 threadIndex)
+{
+  struct island_sleep_job *job = data;
+  for (u32 islandIndex = startIndex; islandIndex < endIndex; islandIndex++) {
+    IslandUpdateSleep(job->islandList, islandIndex, job->entities, job->dt);
+  }
+}
+
 void
 GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *renderer)
 {
@@ -48,32 +468,68 @@ GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *rende
    *****************************************************************/
   if (!state->isInitialized) {
     // memory
-    state->worldArena = (memory_arena){
-        .total = memory->permanentStorageSize - sizeof(*state),
-        .block = memory->permanentStorage + sizeof(*state),
-    };
+    state->worldArena =
+        MemoryArena(memory->permanentStorage + sizeof(*state), memory->permanentStorageSize - sizeof(*state), "world");
     memory_arena *worldArena = &state->worldArena;
 
     // entropy
     state->effectsEntropy = RandomSeed(29);
     random_series *effectsEntropy = &state->effectsEntropy;
 
+    // volumes
+    VolumeRegistryInit(&state->volumeRegistry, MemoryArenaSub(worldArena, 64 * 1024, "volumes"));
+    volume_registry *volumeRegistry = &state->volumeRegistry;
+    state->smallCircleVolume = VolumeRegistryCircle(volumeRegistry, 0.25f);
+
+    // physics
+    state->solverConfig = SolverConfigDefault();
+
     // entities
     state->entityMax = 100 + 1;
     state->entities = MemoryArenaPush(worldArena, sizeof(*state->entities) * state->entityMax);
     state->entityCount = 1; // Entity index 0 means null entity
+    // null entity is static body of terrain contacts, does not limit bounce
+    state->entities[0] = (entity){.restitution = 1.0f};
+
+    // terrain, chain of edges along bottom of screen that rises at both ends.
+    // space below every edge is filled with two triangles.
+    {
+      const f32 groundTop = -5.8f;
+      const f32 groundBottom = groundTop - 2.0f;
+      v2 chain[23];
+      for (u32 pointIndex = 0; pointIndex < ARRAY_COUNT(chain); pointIndex++) {
+        f32 x = -11.0f + (f32)pointIndex;
+        chain[pointIndex] = V2(x, groundTop + 0.5f * Maximum(Absolute(x) - 6.0f, 0.0f));
+      }
+
+      v2 verticies[(ARRAY_COUNT(chain) - 1) * 6];
+      for (u32 edgeIndex = 0; edgeIndex + 1 < ARRAY_COUNT(chain); edgeIndex++) {
+        v2 a = chain[edgeIndex];
+        v2 b = chain[edgeIndex + 1];
+        v2 *quad = verticies + edgeIndex * 6;
+        quad[0] = V2(a.x, groundBottom), quad[1] = V2(b.x, groundBottom), quad[2] = b;
+        quad[3] = V2(a.x, groundBottom), quad[4] = b, quad[5] = a;
+      }
+      TerrainInit(&state->terrain, worldArena, ARRAY_COUNT(verticies) / 3, verticies, 2.0f);
+    }
+
+    // even in dense pile an entity touches only few neighbours and terrain triangles,
+    // pairs beyond this are solved without warm starting
+    u32 pairMax = state->entityMax * 8;
+    PairCacheInit(&state->pairCache, worldArena, pairMax);
+    PairRuleTableInit(&state->pairRules, worldArena, 256);
 
 #if 0
-    volume *bigCircleVolume = VolumeCircle(worldArena, 2.0f);
+    volume *bigCircleVolume = VolumeRegistryCircle(volumeRegistry, 2.0f);
     EntityAdd(state, V2(0.0f, 0.0f), ENTITY_STATIC_MASS, bigCircleVolume, COLOR_PINK_300);
 
-    state->smallCircleVolume = VolumeCircle(worldArena, 0.25f);
     entity *smallCircle = EntityAdd(state, V2(-5.0f, 0.0f), 1.0f, state->smallCircleVolume, COLOR_PINK_500);
     smallCircle->restitution = 0.75f;
 #else
 
-    EntityAdd(state, V2(0.0f, 0.0f), ENTITY_STATIC_MASS, VolumeBox(worldArena, 1.0f, 1.0f), COLOR_PINK_300);
-    EntityAdd(state, V2(-3.0f, 0.0f), 1.0f, VolumeBox(worldArena, 1.0f, 1.0f), COLOR_PINK_500);
+    volume *boxVolume = VolumeRegistryBox(volumeRegistry, 1.0f, 1.0f);
+    EntityAdd(state, V2(0.0f, 0.0f), ENTITY_STATIC_MASS, boxVolume, COLOR_PINK_300);
+    EntityAdd(state, V2(-3.0f, 0.0f), 1.0f, boxVolume, COLOR_PINK_500);
 
 #endif
 
@@ -87,10 +543,18 @@ GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *rende
   transient_state *transientState = memory->transientStorage;
   debug_assert(memory->transientStorageSize >= sizeof(*transientState));
   if (!transientState->isInitialized) {
-    transientState->transientArena = (memory_arena){
-        .total = memory->transientStorageSize - sizeof(*transientState),
-        .block = memory->transientStorage + sizeof(*transientState),
-    };
+    transientState->transientArena = MemoryArena(memory->transientStorage + sizeof(*transientState),
+                                                 memory->transientStorageSize - sizeof(*transientState), "transient");
+    memory_arena *transientArena = &transientState->transientArena;
+
+    // scratch arenas
+    const u64 SCRATCH_ARENA_SIZE = 512 * 1024;
+    for (u32 threadIndex = 0; threadIndex < PLATFORM_THREAD_MAX; threadIndex++) {
+      for (u32 scratchIndex = 0; scratchIndex < MEMORY_SCRATCH_PER_THREAD; scratchIndex++) {
+        transientState->scratchArenas[threadIndex][scratchIndex] =
+            MemoryArenaSub(transientArena, SCRATCH_ARENA_SIZE, "scratch");
+      }
+    }
 
     transientState->isInitialized = 1;
   }
@@ -138,6 +602,8 @@ GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *rende
         f32 mass = 1.0f;
         entity *smallCircle = EntityAdd(state, mousePosition, mass, state->smallCircleVolume, COLOR_PINK_500);
         smallCircle->restitution = 0.75f;
+        // small and fast, would pass through boxes between steps
+        smallCircle->isBullet = 1;
       }
     }
   }
@@ -145,265 +611,301 @@ GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *rende
   /*****************************************************************
    * PHYSICS
    *****************************************************************/
-  rect groundRect = {
-      .min = {-1000.0f, -1000.0f},
-      .max = {1000.0f, -5.8f},
-  };
-
 #if IS_BUILD_DEBUG
   // To visualize physics
   ClearScreen(renderer, COLOR_ZINC_900);
 #endif
 
+  struct entity_pass entityPass = {
+      .state = state,
+      .inputForce = inputForce,
+      .dt = dt,
+  };
+  platform_job_system *jobSystem = &memory->jobSystem;
+  u32 entityPassCount = state->entityCount - 1;
+
   /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
     ▶ Apply forces
     ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
+  PlatformParallelFor(jobSystem, entityPassCount, ENTITY_PASS_BATCH_SIZE, EntityApplyForcesJob, &entityPass);
+
+  // sleeping entity has no velocity, so only applied force can wake it.
+  // waking writes to whole island, so it is not part of parallel pass.
   for (u32 entityIndex = 1; entityIndex < state->entityCount; entityIndex++) {
     struct entity *entity = state->entities + entityIndex;
-    b8 isLastEntity = entityIndex == state->entityCount - 1;
-
-    if (IsEntityStatic(entity))
-      continue;
-
-    // apply input force
-    v2_add_ref(&entity->netForce, v2_scale(inputForce, 30.0f));
-
-    // apply drag force
-    v2 dragForce = GenerateDragForce(entity, 3.81f);
-    v2_add_ref(&entity->netForce, dragForce);
-
-#if 0
-    // apply weight force
-    v2 weightForce = GenerateWeightForce(entity);
-    v2_add_ref(&entity->netForce, weightForce);
-
-    // do not apply any force
-    entity->netForce = V2(0.0f, 0.0f);
-    entity->netTorque = 0.0f;
-#endif
+    if (entity->isSleeping && (v2_length_square(entity->netForce) != 0.0f || entity->netTorque != 0.0f))
+      EntityWake(state->entities, entityIndex);
   }
 
   /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
     ▶ Integrate applied forces
     ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
+  PlatformParallelFor(jobSystem, entityPassCount, ENTITY_PASS_BATCH_SIZE, EntityIntegrateJob, &entityPass);
+
+  /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
+    ▶ Continuous collision of bullets
+    ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
+  PlatformParallelFor(jobSystem, entityPassCount, ENTITY_PASS_BATCH_SIZE, EntityTimeOfImpactJob, &entityPass);
+
+#if (1 && IS_BUILD_DEBUG)
+  // string builder is not thread safe, log after passes
   for (u32 entityIndex = 1; entityIndex < state->entityCount; entityIndex++) {
     struct entity *entity = state->entities + entityIndex;
     b8 isLastEntity = entityIndex == state->entityCount - 1;
 
-    /* LINEAR KINEMATICS
-     *
-     * The rate at which "position" p changes is called "velocity" v.
-     *   v = ∆p/∆t
-     *
-     * The rate at which v changes is called "acceleration" a.
-     *   a = ∆v/∆t
-     *
-     * a = f''(t)
-     * v = ∫f''(t)
-     *   = f'(t)
-     *   = at + v₀
-     * p = ∫f'(t)
-     *   = f(t)
-     *   = ½at² + vt + p₀
-     *
-     * Newton's Law of motion
-     *   F = ma
-     *   where F is force,
-     *         m is mass,
-     *         a is acceleration.
-     *
-     * a = F/m
-     */
-
-    // a = F/m
-    entity->acceleration = v2_scale(entity->netForce, entity->invMass);
-
-    // v = at + v₀
-    v2_add_ref(&entity->velocity, v2_scale(entity->acceleration, dt));
-
-    // p = ½at² + vt + p₀
-    v2_add_ref(&entity->position, v2_add(
-                                      // ½at²
-                                      v2_scale(entity->acceleration, 0.5f * Square(dt)),
-                                      // + vt
-                                      v2_scale(entity->velocity, dt)));
-
-    /* ANGULAR KINEMATICS
-     *
-     * As the body rotates, "angle" θ will change. The rate at which θ changes
-     * is called "angular velocity", ω.
-     *   ω = ∆θ/∆t
-     *
-     * Likewise as body rotates, the rate at which ω changes is called "angular
-     * acceleration", α.
-     *   α = ∆ω/∆t
-     *
-     * α = f''(t)
-     * ω = ∫f''(t)
-     *   = f'(t)
-     *   = αt + ω₀
-     * θ = ∫f'(t)
-     *   = ½αt² + ωt + θ₀
-     *
-     * Angular motion analogous to linear motion.
-     *   τ = I α
-     *   where τ is torque,
-     *           Rotational motion.
-     *         I is moment of inertia.
-     *           Measures how much an object "resists" to change its angular
-     *           acceleration.
-     *           a.k.a. angular mass
-     *           unit: kg m²
-     *
-     * α = τ/I
-     */
-
-    // α = τ/I
-    entity->angularAcceleration = entity->netTorque * entity->invI;
-    // ω = αt + ω₀
-    entity->angularVelocity += entity->angularAcceleration * dt;
-    // θ  = ½αt² + ωt + θ₀
-    entity->rotation += 0.5f * entity->angularAcceleration * Square(dt) + entity->angularVelocity * dt;
+    StringBuilderAppendStringLiteral(sb, "entity #");
+    StringBuilderAppendU64(sb, entityIndex);
+    StringBuilderAppendStringLiteral(sb, "\n");
 
-#if (1 && IS_BUILD_DEBUG)
-    {
-      StringBuilderAppendStringLiteral(sb, "entity #");
-      StringBuilderAppendU64(sb, entityIndex);
-      StringBuilderAppendStringLiteral(sb, "\n");
+    StringBuilderAppendStringLiteral(sb, "  volume: ");
+    switch (entity->volume->type) {
+    case VOLUME_TYPE_CIRCLE: {
+      volume_circle *circle = VolumeGetCircle(entity->volume);
+      StringBuilderAppendStringLiteral(sb, "circle radius: ");
+      StringBuilderAppendF32(sb, circle->radius, 2);
+    } break;
+    case VOLUME_TYPE_BOX: {
+      volume_box *box = VolumeGetBox(entity->volume);
+      StringBuilderAppendStringLiteral(sb, "box width: ");
+      StringBuilderAppendF32(sb, box->width, 2);
+      StringBuilderAppendStringLiteral(sb, " height: ");
+      StringBuilderAppendF32(sb, box->height, 2);
+    } break;
+    case VOLUME_TYPE_TRIANGLE: {
+      volume_triangle *triangle = VolumeGetTriangle(entity->volume);
+      StringBuilderAppendStringLiteral(sb, "triangle area: ");
+      StringBuilderAppendF32(sb, triangle->area, 2);
+    } break;
+    default: {
+      StringBuilderAppendStringLiteral(sb, "unknown");
+    } break;
+    }
+    StringBuilderAppendStringLiteral(sb, " mass: ");
+    StringBuilderAppendF32(sb, entity->mass, 2);
+    StringBuilderAppendStringLiteral(sb, "kg");
+    StringBuilderAppendStringLiteral(sb, "\n");
 
-      StringBuilderAppendStringLiteral(sb, "  volume: ");
-      switch (entity->volume->type) {
-      case VOLUME_TYPE_CIRCLE: {
-        volume_circle *circle = VolumeGetCircle(entity->volume);
-        StringBuilderAppendStringLiteral(sb, "circle radius: ");
-        StringBuilderAppendF32(sb, circle->radius, 2);
-      } break;
-      case VOLUME_TYPE_BOX: {
-        volume_box *box = VolumeGetBox(entity->volume);
-        StringBuilderAppendStringLiteral(sb, "box width: ");
-        StringBuilderAppendF32(sb, box->width, 2);
-        StringBuilderAppendStringLiteral(sb, " height: ");
-        StringBuilderAppendF32(sb, box->height, 2);
-      } break;
-      default: {
-        StringBuilderAppendStringLiteral(sb, "unknown");
-      } break;
-      }
-      StringBuilderAppendStringLiteral(sb, " mass: ");
-      StringBuilderAppendF32(sb, entity->mass, 2);
-      StringBuilderAppendStringLiteral(sb, "kg");
-      StringBuilderAppendStringLiteral(sb, "\n");
+    StringBuilderAppendStringLiteral(sb, "  pos: ");
+    StringBuilderAppendF32(sb, entity->position.x, 2);
+    StringBuilderAppendStringLiteral(sb, ", ");
+    StringBuilderAppendF32(sb, entity->position.y, 2);
+    StringBuilderAppendStringLiteral(sb, "\n");
 
-      StringBuilderAppendStringLiteral(sb, "  pos: ");
-      StringBuilderAppendF32(sb, entity->position.x, 2);
-      StringBuilderAppendStringLiteral(sb, ", ");
-      StringBuilderAppendF32(sb, entity->position.y, 2);
-      StringBuilderAppendStringLiteral(sb, "\n");
+    StringBuilderAppendStringLiteral(sb, "  vel: ");
+    StringBuilderAppendF32(sb, entity->velocity.x, 10);
+    StringBuilderAppendStringLiteral(sb, ", ");
+    StringBuilderAppendF32(sb, entity->velocity.y, 10);
+    StringBuilderAppendStringLiteral(sb, "\n");
 
-      StringBuilderAppendStringLiteral(sb, "  vel: ");
-      StringBuilderAppendF32(sb, entity->velocity.x, 10);
-      StringBuilderAppendStringLiteral(sb, ", ");
-      StringBuilderAppendF32(sb, entity->velocity.y, 10);
-      StringBuilderAppendStringLiteral(sb, "\n");
+    StringBuilderAppendStringLiteral(sb, "  acc: ");
+    StringBuilderAppendF32(sb, entity->acceleration.x, 2);
+    StringBuilderAppendStringLiteral(sb, ", ");
+    StringBuilderAppendF32(sb, entity->acceleration.y, 2);
+    StringBuilderAppendStringLiteral(sb, "\n");
 
-      StringBuilderAppendStringLiteral(sb, "  acc: ");
-      StringBuilderAppendF32(sb, entity->acceleration.x, 2);
-      StringBuilderAppendStringLiteral(sb, ", ");
-      StringBuilderAppendF32(sb, entity->acceleration.y, 2);
-      StringBuilderAppendStringLiteral(sb, "\n");
+    StringBuilderAppendStringLiteral(sb, "  F:   ");
+    StringBuilderAppendF32(sb, entity->netForce.x, 2);
+    StringBuilderAppendStringLiteral(sb, ", ");
+    StringBuilderAppendF32(sb, entity->netForce.y, 2);
+    StringBuilderAppendStringLiteral(sb, "\n");
 
-      StringBuilderAppendStringLiteral(sb, "  F:   ");
-      StringBuilderAppendF32(sb, entity->netForce.x, 2);
-      StringBuilderAppendStringLiteral(sb, ", ");
-      StringBuilderAppendF32(sb, entity->netForce.y, 2);
-      StringBuilderAppendStringLiteral(sb, "\n");
+    StringBuilderAppendStringLiteral(sb, "  θ: ");
+    StringBuilderAppendF32(sb, entity->rotation, 2);
+    StringBuilderAppendStringLiteral(sb, "  ω: ");
+    StringBuilderAppendF32(sb, entity->angularVelocity, 2);
+    StringBuilderAppendStringLiteral(sb, "  α: ");
+    StringBuilderAppendF32(sb, entity->angularAcceleration, 2);
+    StringBuilderAppendStringLiteral(sb, "  τ: ");
+    StringBuilderAppendF32(sb, entity->netTorque, 2);
 
-      StringBuilderAppendStringLiteral(sb, "  θ: ");
-      StringBuilderAppendF32(sb, entity->rotation, 2);
-      StringBuilderAppendStringLiteral(sb, "  ω: ");
-      StringBuilderAppendF32(sb, entity->angularVelocity, 2);
-      StringBuilderAppendStringLiteral(sb, "  α: ");
-      StringBuilderAppendF32(sb, entity->angularAcceleration, 2);
-      StringBuilderAppendStringLiteral(sb, "  τ: ");
-      StringBuilderAppendF32(sb, entity->netTorque, 2);
-
-      if (isLastEntity) {
-        StringBuilderAppendStringLiteral(sb, "\n");
-        StringBuilderAppendStringLiteral(sb, "****************************************************************");
-      }
+    if (isLastEntity) {
       StringBuilderAppendStringLiteral(sb, "\n");
-
-      string string = StringBuilderFlush(sb);
-      LogMessage(&string);
+      StringBuilderAppendStringLiteral(sb, "****************************************************************");
     }
-#endif
-
-    // clear forces
-    entity->netForce = (v2){0.0f, 0.0f};
-    entity->netTorque = 0.0f;
-
-    // TODO: Ground collision is broken
-    if (IsPointInsideRect(entity->position, groundRect)) {
-      v2 groundNormal = {0.0f, 1.0f};
+    StringBuilderAppendStringLiteral(sb, "\n");
 
-      // reflect
-      // v' = v - 2(v∙n)n
-      entity->velocity =
-          v2_sub(entity->velocity, v2_scale(groundNormal, 2.0f * v2_dot(entity->velocity, groundNormal)));
-    }
+    string string = StringBuilderFlush(sb);
+    LogMessage(&string);
   }
+#endif
 
   /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
     ▶ COLLISION DETECTION & RESOLUTION
     ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
-  for (u32 entityAIndex = 1; entityAIndex < state->entityCount; entityAIndex++) {
-    struct entity *entityA = state->entities + entityAIndex;
-    for (u32 entityBIndex = entityAIndex + 1; entityBIndex < state->entityCount; entityBIndex++) {
-      struct entity *entityB = state->entities + entityBIndex;
+  {
+    // manifolds make collisions too large for scratch arenas
+    memory_temp physicsMemory = MemoryTempBegin(&transientState->transientArena);
+    memory_arena *physicsArena = physicsMemory.arena;
+
+    /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
+      ▶ BROADPHASE
+      ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
+    u32 pairCount;
+    collision_pair *pairs =
+        BroadphaseSweepAndPrune(physicsArena, state->entities, state->entityCount, &state->pairRules, &pairCount);
+    u32 circlePairCount = BroadphaseBucketPairs(physicsArena, state->entities, pairs, pairCount);
+
+    // terrain is looked up in its own grid
+    u32 terrainPairCount;
+    terrain_pair *terrainPairs =
+        TerrainBroadphase(physicsArena, &state->terrain, state->entities, state->entityCount, &terrainPairCount);
+
+    // pairs take over their cache entries from previous frame
+    PairCacheSwap(&state->pairCache);
+    for (u32 pairIndex = 0; pairIndex < pairCount; pairIndex++) {
+      collision_pair *pair = pairs + pairIndex;
+      pair->cache = PairCacheInsert(&state->pairCache, pair->entityAIndex, pair->entityBIndex);
+    }
+    for (u32 pairIndex = 0; pairIndex < terrainPairCount; pairIndex++) {
+      terrain_pair *pair = terrainPairs + pairIndex;
+      pair->cache = PairCacheInsertTerrain(&state->pairCache, pair->triangleIndex, pair->entityIndex);
+    }
 
-      /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
-        ▶ COLLISION DETECTION
-        ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
+    /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
+      ▶ NARROWPHASE
+      ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
+    u32 threadCount = jobSystem->queue ? jobSystem->threadCount : 1;
+    struct narrowphase_job narrowphase = {
+        .entities = state->entities,
+        .pairs = pairs,
+        .circles = CirclePack(physicsArena, state->entities, state->entityCount),
+        .circlePairCount = circlePairCount,
+    };
 
-      // entity cannot collide with itself
-      if (entityAIndex == entityBIndex)
-        continue;
+    // pushed before outputs, so outputs can be released right after merge
+    collision *collisions = MemoryArenaPush(physicsArena, sizeof(*collisions) * (pairCount + terrainPairCount));
+
+    memory_temp outputMemory = NarrowphaseOutputsBegin(physicsArena, narrowphase.outputs, threadCount, pairCount);
+    PlatformParallelFor(jobSystem, pairCount, NARROWPHASE_BATCH_SIZE, NarrowphaseJob, &narrowphase);
+    u32 collisionCount = NarrowphaseMerge(narrowphase.outputs, threadCount, collisions);
+    MemoryTempEnd(&outputMemory);
+
+    // terrain collisions follow collisions between entities
+    struct terrain_narrowphase_job terrainNarrowphase = {
+        .terrain = &state->terrain,
+        .entities = state->entities,
+        .pairs = terrainPairs,
+    };
+    outputMemory = NarrowphaseOutputsBegin(physicsArena, terrainNarrowphase.outputs, threadCount, terrainPairCount);
+    PlatformParallelFor(jobSystem, terrainPairCount, NARROWPHASE_BATCH_SIZE, TerrainNarrowphaseJob,
+                        &terrainNarrowphase);
+    collisionCount += NarrowphaseMerge(terrainNarrowphase.outputs, threadCount, collisions + collisionCount);
+    MemoryTempEnd(&outputMemory);
+
+    /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
+      ▶ COLLISION RESOLUTION
+      ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
+    for (u32 entityIndex = 1; entityIndex < state->entityCount; entityIndex++) {
+      struct entity *entity = state->entities + entityIndex;
+      entity->isColliding = 0;
+    }
+
+    for (u32 collisionIndex = 0; collisionIndex < collisionCount; collisionIndex++) {
+      collision *collision = collisions + collisionIndex;
+      struct entity *entityA = state->entities + collision->entityAIndex;
+      struct entity *entityB = state->entities + collision->entityBIndex;
 
-      contact contact = {};
-      b8 isColliding = CollisionDetect(entityA, entityB, &contact);
 #if (1 && IS_BUILD_DEBUG)
-      if (isColliding) {
-        DrawRect(renderer, RectCenterDim(contact.start, V2(0.1f, 0.1f)), COLOR_BLUE_200);
-        DrawRect(renderer, RectCenterDim(contact.end, V2(0.1f, 0.1f)), COLOR_BLUE_700);
-        DrawLine(renderer, contact.start, v2_add(contact.start, v2_scale(contact.normal, 0.25f)), COLOR_BLUE_500, 0.1f);
+      contact *contact = &collision->contact;
+      for (u32 pointIndex = 0; pointIndex < contact->pointCount; pointIndex++) {
+        contact_point *point = contact->points + pointIndex;
+        DrawRect(renderer, RectCenterDim(point->start, V2(0.1f, 0.1f)), COLOR_BLUE_200);
+        DrawRect(renderer, RectCenterDim(point->end, V2(0.1f, 0.1f)), COLOR_BLUE_700);
+        DrawLine(renderer, point->start, v2_add(point->start, v2_scale(contact->normal, 0.25f)), COLOR_BLUE_500,
+                 0.1f);
       }
 #endif
 
-      /*▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼
-        ▶ COLLISION RESOLUTION
-        ▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲▼▲*/
-      if (isColliding && contact.depth != 0.0f) {
-        CollisionResolve(entityA, entityB, &contact);
-      }
+      entityA->isColliding = 1;
+      entityB->isColliding = 1;
 
-      entityA->isColliding = isColliding;
-      entityB->isColliding = isColliding;
+      // awake entity wakes up sleeping entity it touches, with island it sleeps in
+      if (entityA->isSleeping && IsEntityAwake(entityB))
+        EntityWake(state->entities, collision->entityAIndex);
+      if (entityB->isSleeping && IsEntityAwake(entityA))
+        EntityWake(state->entities, collision->entityBIndex);
 
 #if (0 && IS_BUILD_DEBUG)
       StringBuilderAppendString(sb, &STRING_FROM_ZERO_TERMINATED("Entity #"));
-      StringBuilderAppendU64(sb, entityAIndex);
+      StringBuilderAppendU64(sb, collision->entityAIndex);
       StringBuilderAppendString(sb, &STRING_FROM_ZERO_TERMINATED(" and #"));
-      StringBuilderAppendU64(sb, entityBIndex);
-      StringBuilderAppendString(sb, &STRING_FROM_ZERO_TERMINATED(" is "));
-      if (isColliding)
-        StringBuilderAppendString(sb, &STRING_FROM_ZERO_TERMINATED("colliding."));
-      else
-        StringBuilderAppendString(sb, &STRING_FROM_ZERO_TERMINATED("NOT colliding."));
-      StringBuilderAppendString(sb, &STRING_FROM_ZERO_TERMINATED("\n"));
+      StringBuilderAppendU64(sb, collision->entityBIndex);
+      StringBuilderAppendString(sb, &STRING_FROM_ZERO_TERMINATED(" is colliding.\n"));
       string string = StringBuilderFlush(sb);
       LogMessage(&string);
 #endif
     }
+
+    island_list islandList =
+        IslandBuild(physicsArena, state->entities, state->entityCount, collisions, collisionCount);
+
+    /* Small islands are solved whole on one thread, many islands at once.
+     * Large islands are spread over threads by coloring. They are colored
+     * before constraints are prepared, so constraints come out grouped by color.
+     */
+    u32 *smallIslandIndices = MemoryArenaPush(physicsArena, sizeof(*smallIslandIndices) * islandList.islandCount);
+    u32 smallIslandCount = 0;
+    struct island_coloring *largeIslands =
+        MemoryArenaPush(physicsArena, sizeof(*largeIslands) * islandList.islandCount);
+    u32 largeIslandCount = 0;
+    for (u32 islandIndex = 0; islandIndex < islandList.islandCount; islandIndex++) {
+      island *island = islandList.islands + islandIndex;
+      if (island->collisionCount == 0)
+        continue;
+
+      if (island->collisionCount < ISLAND_COLOR_THRESHOLD) {
+        smallIslandIndices[smallIslandCount] = islandIndex;
+        smallIslandCount++;
+        continue;
+      }
+
+      struct island_coloring *coloring = largeIslands + largeIslandCount;
+      largeIslandCount++;
+      coloring->islandIndex = islandIndex;
+
+      memory_temp tempMemory = MemoryTempBegin(physicsArena);
+      collision *islandCollisions = islandList.collisions + island->collisionOffset;
+      collision *coloredCollisions =
+          MemoryArenaPush(tempMemory.arena, sizeof(*coloredCollisions) * island->collisionCount);
+      coloring->colorCount = CollisionColor(tempMemory.arena, state->entities, state->entityCount, islandCollisions,
+                                            island->collisionCount, coloredCollisions, coloring->colorOffsets);
+      memcpy(islandCollisions, coloredCollisions, sizeof(*coloredCollisions) * island->collisionCount);
+      MemoryTempEnd(&tempMemory);
+    }
+
+    contact_constraint *constraints = MemoryArenaPush(physicsArena, sizeof(*constraints) * islandList.collisionCount);
+    struct solver_job solver = {
+        .entities = state->entities,
+        .config = &state->solverConfig,
+        .collisions = islandList.collisions,
+        .constraints = constraints,
+    };
+    PlatformParallelFor(jobSystem, islandList.collisionCount, SOLVER_BATCH_SIZE, SolverPrepareJob, &solver);
+
+    struct island_solve_job islandSolve = {
+        .solver = &solver,
+        .islandList = &islandList,
+        .islandIndices = smallIslandIndices,
+    };
+    PlatformParallelFor(jobSystem, smallIslandCount, ISLAND_SOLVE_BATCH_SIZE, IslandSolveJob, &islandSolve);
+
+    for (u32 largeIslandIndex = 0; largeIslandIndex < largeIslandCount; largeIslandIndex++) {
+      struct island_coloring *coloring = largeIslands + largeIslandIndex;
+      island *island = islandList.islands + coloring->islandIndex;
+      struct solver_job islandSolver = solver;
+      islandSolver.collisions += island->collisionOffset;
+      islandSolver.constraints += island->collisionOffset;
+      SolverSolveColored(jobSystem, &islandSolver, coloring->colorCount, coloring->colorOffsets);
+    }
+
+    struct island_sleep_job islandSleep = {
+        .entities = state->entities,
+        .islandList = &islandList,
+        .dt = dt,
+    };
+    PlatformParallelFor(jobSystem, islandList.islandCount, ISLAND_SLEEP_BATCH_SIZE, IslandSleepJob, &islandSleep);
+
+    MemoryTempEnd(&physicsMemory);
   }
 
   /*****************************************************************
@@ -420,8 +922,15 @@ GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *rende
   DrawLine(renderer, (v2){0, -100}, (v2){0, 100}, COLOR_BLUE_500, 0);
 #endif
 
-  // ground
-  DrawRect(renderer, groundRect, COLOR_GRAY_800);
+  // terrain
+  for (u32 triangleIndex = 0; triangleIndex < state->terrain.triangleCount; triangleIndex++) {
+    volume_triangle *triangle = VolumeGetTriangle(state->terrain.triangles[triangleIndex]);
+    v2 position = state->terrain.positions[triangleIndex];
+    v2 verticies[3];
+    for (u32 vertexIndex = 0; vertexIndex < ARRAY_COUNT(verticies); vertexIndex++)
+      verticies[vertexIndex] = v2_add(position, triangle->verticies[vertexIndex]);
+    DrawConvexPolygon(renderer, verticies, ARRAY_COUNT(verticies), COLOR_GRAY_800);
+  }
 
   // mouse
   DrawCrosshair(renderer, mousePosition, 0.5f, COLOR_RED_500);
@@ -464,6 +973,17 @@ GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *rende
       f32 rotation = entity->rotation;
       DrawRectRotated(renderer, rect, rotation, color);
     } break;
+    case VOLUME_TYPE_POLYGON:
+    case VOLUME_TYPE_TRIANGLE: {
+      __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&transientState->transientArena);
+      local_polygon polygon = VolumeGetLocalPolygon(entity->volume);
+      v2 *verticies = MemoryArenaPush(tempMemory.arena, sizeof(*verticies) * polygon.count);
+      for (u32 vertexIndex = 0; vertexIndex < polygon.count; vertexIndex++) {
+        verticies[vertexIndex] =
+            v2_add(entity->position, m2_mul_v2(entity->rotationMatrix, polygon.verticies[vertexIndex]));
+      }
+      DrawConvexPolygon(renderer, verticies, polygon.count, color);
+    } break;
     default: {
       breakpoint("drawing volume type not implemented");
     } break;
@@ -471,4 +991,22 @@ GameUpdateAndRender(game_memory *memory, game_input *input, game_renderer *rende
   }
 
   RenderFrame(renderer);
+
+  // arena usage, logged every frame when enabled
+#if (0 && IS_BUILD_DEBUG)
+  {
+    memory_arena *arenas[] = {
+        &state->worldArena,
+        &state->volumeRegistry.memory,
+        &transientState->transientArena,
+        &renderer->memory,
+    };
+    for (u32 arenaIndex = 0; arenaIndex < ARRAY_COUNT(arenas); arenaIndex++) {
+      StringBuilderAppendMemoryArena(sb, arenas[arenaIndex]);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string string = StringBuilderFlush(sb);
+      LogMessage(&string);
+    }
+  }
+#endif
 }
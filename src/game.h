@@ -17,6 +17,7 @@ typedef struct {
   b8 isInitialized : 1;
 
   memory_arena worldArena;
+  volume_registry volumeRegistry;
 
   random_series effectsEntropy;
   entity *entities;
@@ -24,6 +25,10 @@ typedef struct {
   u32 entityMax;
 
   volume *smallCircleVolume;
+  solver_config solverConfig;
+  pair_cache pairCache;
+  pair_rule_table pairRules;
+  terrain terrain;
 
   f32 time; // unit: sec
 } game_state;
@@ -31,6 +36,9 @@ typedef struct {
 typedef struct {
   b8 isInitialized : 1;
   memory_arena transientArena;
+  // Carved from transient storage. Indexed by thread index, main thread is 0.
+  // see: ScratchBegin()
+  memory_arena scratchArenas[PLATFORM_THREAD_MAX][MEMORY_SCRATCH_PER_THREAD];
   string_builder *sb;
 } transient_state;
 
@@ -0,0 +1,248 @@
+#include "job.h"
+#include "assert.h"
+
+// Index of thread in job queue. Main thread is 0.
+static __thread u32 jobThreadIndex;
+
+/*
+ * Pushes job to bottom of deque. Only owner of deque can push.
+ * @return 0 if deque is full
+ */
+static b8
+JobDequePush(job_deque *deque, job_entry job)
+{
+  s64 bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+  s64 top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  if (bottom - top >= JOB_DEQUE_CAPACITY)
+    return 0;
+
+  deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)] = job;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+  return 1;
+}
+
+/*
+ * Pops job from bottom of deque. Only owner of deque can pop.
+ * @return 0 if deque is empty
+ */
+static b8
+JobDequePop(job_deque *deque, job_entry *job)
+{
+  s64 bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+  __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  s64 top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+  b8 isPopped = 0;
+  if (top <= bottom) {
+    *job = deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)];
+    isPopped = 1;
+    if (top == bottom) {
+      // last job, race against thieves
+      isPopped = __atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+      __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+  } else {
+    // empty
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+  }
+
+  return isPopped;
+}
+
+/*
+ * Steals job from top of deque. Any thread can steal.
+ * @return 0 if deque is empty or another thread won the race
+ */
+static b8
+JobDequeSteal(job_deque *deque, job_entry *job)
+{
+  s64 top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  s64 bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+  if (top >= bottom)
+    return 0;
+
+  *job = deque->jobs[top & (JOB_DEQUE_CAPACITY - 1)];
+  return __atomic_compare_exchange_n(&deque->top, &top, top + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static inline void
+JobRun(job_entry *job, u32 threadIndex)
+{
+  job->function(job->data, threadIndex);
+  if (job->counter)
+    __atomic_sub_fetch(&job->counter->value, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Runs one job from own deque, or steals one from other threads.
+ * @return 0 if there was no job to run
+ */
+static b8
+JobRunNext(platform_job_queue *queue, u32 threadIndex)
+{
+  job_entry job;
+  if (JobDequePop(queue->deques + threadIndex, &job)) {
+    JobRun(&job, threadIndex);
+    return 1;
+  }
+
+  for (u32 offset = 1; offset < queue->threadCount; offset++) {
+    u32 victimIndex = (threadIndex + offset) % queue->threadCount;
+    if (JobDequeSteal(queue->deques + victimIndex, &job)) {
+      JobRun(&job, threadIndex);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int
+JobWorkerMain(void *data)
+{
+  job_worker *worker = data;
+  platform_job_queue *queue = worker->queue;
+  u32 threadIndex = worker->threadIndex;
+  jobThreadIndex = threadIndex;
+
+  while (!__atomic_load_n(&queue->isQuitting, __ATOMIC_ACQUIRE)) {
+    if (JobRunNext(queue, threadIndex))
+      continue;
+    SDL_WaitSemaphore(queue->wakeUp);
+  }
+
+  return 0;
+}
+
+static b8
+JobQueueInit(platform_job_queue *queue, u32 threadCount)
+{
+  debug_assert(threadCount > 0 && threadCount <= PLATFORM_THREAD_MAX);
+  queue->threadCount = threadCount;
+  queue->isQuitting = 0;
+  jobThreadIndex = 0;
+
+  queue->wakeUp = SDL_CreateSemaphore(0);
+  if (!queue->wakeUp)
+    return 0;
+
+  for (u32 threadIndex = 1; threadIndex < threadCount; threadIndex++) {
+    job_worker *worker = queue->workers + threadIndex;
+    worker->queue = queue;
+    worker->threadIndex = threadIndex;
+    worker->thread = SDL_CreateThread(JobWorkerMain, "job worker", worker);
+    if (!worker->thread) {
+      // continue with the workers that could be started
+      queue->threadCount = threadIndex;
+      break;
+    }
+  }
+
+  return 1;
+}
+
+static void
+JobQueueDestroy(platform_job_queue *queue)
+{
+  __atomic_store_n(&queue->isQuitting, 1, __ATOMIC_RELEASE);
+  for (u32 threadIndex = 1; threadIndex < queue->threadCount; threadIndex++)
+    SDL_SignalSemaphore(queue->wakeUp);
+
+  for (u32 threadIndex = 1; threadIndex < queue->threadCount; threadIndex++) {
+    job_worker *worker = queue->workers + threadIndex;
+    SDL_WaitThread(worker->thread, 0);
+    worker->thread = 0;
+  }
+
+  SDL_DestroySemaphore(queue->wakeUp);
+  queue->wakeUp = 0;
+}
+
+static void
+JobAdd(platform_job_queue *queue, pfnPlatformJob function, void *data, platform_job_counter *counter)
+{
+  u32 threadIndex = jobThreadIndex;
+  job_entry job = {
+      .function = function,
+      .data = data,
+      .counter = counter,
+  };
+
+  if (counter)
+    __atomic_add_fetch(&counter->value, 1, __ATOMIC_RELAXED);
+
+  if (!JobDequePush(queue->deques + threadIndex, job)) {
+    // deque is full, do not lose the job
+    JobRun(&job, threadIndex);
+    return;
+  }
+
+  SDL_SignalSemaphore(queue->wakeUp);
+}
+
+static void
+JobWait(platform_job_queue *queue, platform_job_counter *counter)
+{
+  u32 threadIndex = jobThreadIndex;
+  while (__atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) != 0) {
+    if (!JobRunNext(queue, threadIndex))
+      SDL_CPUPauseInstruction();
+  }
+}
+
+typedef struct {
+  pfnPlatformParallelForJob function;
+  void *data;
+  u32 count;
+  u32 batchSize;
+  u32 nextIndex; // first index of next batch to be claimed
+} job_parallel_for;
+
+/*
+ * Claims batches until there is none left. Because batches are claimed on
+ * demand, a thread that is slowed down does not hold back others.
+ */
+static void
+JobParallelForRun(void *data, u32 threadIndex)
+{
+  job_parallel_for *parallelFor = data;
+  for (;;) {
+    u32 startIndex = __atomic_fetch_add(&parallelFor->nextIndex, parallelFor->batchSize, __ATOMIC_RELAXED);
+    if (startIndex >= parallelFor->count)
+      break;
+
+    u32 endIndex = startIndex + parallelFor->batchSize;
+    if (endIndex > parallelFor->count || endIndex < startIndex)
+      endIndex = parallelFor->count;
+    parallelFor->function(parallelFor->data, startIndex, endIndex, threadIndex);
+  }
+}
+
+static void
+JobParallelFor(platform_job_queue *queue, u32 count, u32 batchSize, pfnPlatformParallelForJob function, void *data)
+{
+  if (batchSize == 0)
+    batchSize = 1;
+
+  job_parallel_for parallelFor = {
+      .function = function,
+      .data = data,
+      .count = count,
+      .batchSize = batchSize,
+  };
+
+  // one helper per thread that can have a batch, calling thread is one of them
+  u32 batchCount = (count + batchSize - 1) / batchSize;
+  u32 helperCount = Minimum(batchCount, queue->threadCount) - 1;
+
+  platform_job_counter counter = {};
+  for (u32 helperIndex = 0; helperIndex < helperCount; helperIndex++)
+    JobAdd(queue, JobParallelForRun, &parallelFor, &counter);
+
+  JobParallelForRun(&parallelFor, jobThreadIndex);
+  JobWait(queue, &counter);
+}
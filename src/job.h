@@ -0,0 +1,68 @@
+#pragma once
+
+#include "compiler.h"
+#include "memory.h"
+#include "platform.h"
+#include "type.h"
+#include <SDL3/SDL.h>
+
+/*
+ * Platform side of job system. see: platform_job_system
+ *
+ * Each thread owns a deque of jobs.
+ * - Owner pushes and pops at bottom, in LIFO order, which keeps recently
+ *   touched data in its cache.
+ * - Other threads steal from top, in FIFO order, which takes oldest and
+ *   usually largest work.
+ * see:
+ * - https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+ *   "Chase, Lev - Dynamic Circular Work-Stealing Deque"
+ * - https://fzn.fr/readings/ppopp13.pdf
+ *   "Lê, Pop, Cohen, Nardelli - Correct and Efficient Work-Stealing for Weak Memory Models"
+ */
+
+#define JOB_DEQUE_CAPACITY 1024 // must be power of two
+
+typedef struct {
+  pfnPlatformJob function;
+  void *data;
+  platform_job_counter *counter;
+} job_entry;
+
+typedef struct {
+  __attribute__((aligned(CACHE_LINE_SIZE))) s64 top; // stolen from
+  __attribute__((aligned(CACHE_LINE_SIZE))) s64 bottom; // owner pushes and pops
+  job_entry jobs[JOB_DEQUE_CAPACITY];
+} job_deque;
+
+typedef struct {
+  platform_job_queue *queue;
+  u32 threadIndex;
+  SDL_Thread *thread;
+} job_worker;
+
+struct platform_job_queue {
+  u32 threadCount; // including main thread
+  s32 isQuitting;
+  SDL_Semaphore *wakeUp; // signaled once per added job
+  job_deque deques[PLATFORM_THREAD_MAX];
+  job_worker workers[PLATFORM_THREAD_MAX];
+};
+
+/*
+ * Starts threadCount - 1 worker threads. Calling thread becomes thread 0.
+ */
+static b8
+JobQueueInit(platform_job_queue *queue, u32 threadCount);
+
+static void
+JobQueueDestroy(platform_job_queue *queue);
+
+static void
+JobAdd(platform_job_queue *queue, pfnPlatformJob function, void *data, platform_job_counter *counter);
+
+static void
+JobWait(platform_job_queue *queue, platform_job_counter *counter);
+
+static void
+JobParallelFor(platform_job_queue *queue, u32 count, u32 batchSize, pfnPlatformParallelForJob function, void *data);
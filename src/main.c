@@ -3,6 +3,8 @@
 #include "log.h"
 #include "type.h"
 
+#include "job.c"
+
 #if !IS_BUILD_DEBUG
 #include "game.c"
 #endif
@@ -24,6 +26,7 @@ typedef struct {
   f32 invWindowWidth;
   f32 invWindowHeight;
   game_memory memory;
+  platform_job_queue jobQueue;
   game_input inputs[2];
   u32 inputIndex : 1;
   game_renderer renderer;
@@ -504,7 +507,7 @@ SDL_AppInit(void **appstate, int argc, char *argv[])
   {
     memory.total =
         PERMANANT_MEMORY_USAGE + TRANSIENT_MEMORY_USAGE + RENDERER_MEMORY_USAGE + STRING_BUILDER_MEMORY_USAGE;
-    memory.total += sizeof(sdl_state); // for app state tracking
+    memory.total += sizeof(sdl_state) + CACHE_LINE_SIZE; // for app state tracking
     memory.block = SDL_malloc(memory.total);
     if (memory.block == 0) {
       return SDL_APP_FAILURE;
@@ -512,7 +515,7 @@ SDL_AppInit(void **appstate, int argc, char *argv[])
   }
 
   // setup game state
-  sdl_state *state = MemoryArenaPush(&memory, sizeof(*state));
+  sdl_state *state = MemoryArenaPushAligned(&memory, sizeof(*state), CACHE_LINE_SIZE);
   memset(state, 0, sizeof(*state));
 
   const s32 windowWidth = 1280;
@@ -522,14 +525,14 @@ SDL_AppInit(void **appstate, int argc, char *argv[])
 
   game_renderer *renderer = &state->renderer;
   {
-    renderer->memory = MemoryArenaSub(&memory, RENDERER_MEMORY_USAGE);
+    renderer->memory = MemoryArenaSub(&memory, RENDERER_MEMORY_USAGE, "renderer");
     memset(renderer->memory.block, 0, renderer->memory.total);
 
     renderer->screenCenter = (v2){(f32)windowWidth * 0.5f, (f32)windowHeight * 0.5f};
   }
 
   { // - string builder
-    memory_arena sbMemory = MemoryArenaSub(&memory, STRING_BUILDER_MEMORY_USAGE);
+    memory_arena sbMemory = MemoryArenaSub(&memory, STRING_BUILDER_MEMORY_USAGE, "string builder");
     string *stringBuffer = MakeString(&sbMemory, 32);
     string *outBuffer = MakeString(&sbMemory, sbMemory.total - sbMemory.used - sizeof(*outBuffer));
 
@@ -557,7 +560,25 @@ SDL_AppInit(void **appstate, int argc, char *argv[])
     transient_state *transientState = gameMemory->transientStorage;
     transientState->sb = &state->sb;
   }
-  debug_assert(memory.used == memory.total && "Warning: you are not using specified memory amount");
+  debug_assert(memory.used <= memory.total && memory.total - memory.used < CACHE_LINE_SIZE &&
+               "Warning: you are not using specified memory amount");
+
+  { // setup job system
+    s32 cpuCount = SDL_GetNumLogicalCPUCores();
+    u32 threadCount = cpuCount > 0 ? (u32)cpuCount : 1;
+    if (threadCount > PLATFORM_THREAD_MAX)
+      threadCount = PLATFORM_THREAD_MAX;
+
+    platform_job_queue *queue = &state->jobQueue;
+    if (JobQueueInit(queue, threadCount)) {
+      platform_job_system *jobSystem = &state->memory.jobSystem;
+      jobSystem->queue = queue;
+      jobSystem->threadCount = queue->threadCount;
+      jobSystem->JobAdd = JobAdd;
+      jobSystem->JobWait = JobWait;
+      jobSystem->ParallelFor = JobParallelFor;
+    }
+  }
 
   // SDL
   *appstate = state;
@@ -591,5 +612,7 @@ void
 SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
   sdl_state *state = appstate;
+  if (state->memory.jobSystem.queue)
+    JobQueueDestroy(&state->jobQueue);
   SDL_DestroyRenderer(state->renderer.renderer);
 }
@@ -2,6 +2,10 @@
 #include "compiler.h"
 #include "math.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 static u8 *
 VolumeGetType(volume *volume)
 {
@@ -30,14 +34,22 @@ VolumeGetBox(volume *volume)
   return (volume_box *)VolumeGetType(volume);
 }
 
+static volume_triangle *
+VolumeGetTriangle(volume *volume)
+{
+  debug_assert(volume->type == VOLUME_TYPE_TRIANGLE);
+  return (volume_triangle *)VolumeGetType(volume);
+}
+
 static volume *
 Volume(memory_arena *memory, volume_type type, u64 typeSize)
 {
   volume *result = 0;
 
   u64 size = sizeof(*result) + typeSize;
-  result = MemoryArenaPush(memory, size);
+  result = MemoryArenaPushAligned(memory, size, sizeof(void *));
   result->type = type;
+  result->index = 0;
 
   return result;
 }
@@ -56,9 +68,235 @@ VolumeCircle(memory_arena *memory, f32 radius)
   return volume;
 }
 
+static u32
+PolygonGetPaddedCount(u32 vertexCount)
+{
+  return (vertexCount + VOLUME_POLYGON_SIMD_WIDTH - 1) / VOLUME_POLYGON_SIMD_WIDTH * VOLUME_POLYGON_SIMD_WIDTH;
+}
+
+/*
+ * Index of vertex furthest along direction, max of v∙d. On ties lowest index
+ * wins, so padding that repeats first vertex is never returned.
+ * @param xs, ys verticies in SoA layout, padded to VOLUME_POLYGON_SIMD_WIDTH
+ */
+static u32
+PolygonSupportIndex(f32 *xs, f32 *ys, u32 vertexCount, v2 direction)
+{
+  u32 paddedCount = PolygonGetPaddedCount(vertexCount);
+
+#if defined(__AVX2__)
+  static_assert(VOLUME_POLYGON_SIMD_WIDTH == 8);
+  __m256 dx = _mm256_set1_ps(direction.x);
+  __m256 dy = _mm256_set1_ps(direction.y);
+  __m256i step = _mm256_set1_epi32(VOLUME_POLYGON_SIMD_WIDTH);
+  __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  // every lane keeps its own max, strict compare keeps lowest index per lane
+  __m256 maxDots = _mm256_set1_ps(F32_LOWEST);
+  __m256i maxIndices = _mm256_setzero_si256();
+  for (u32 vertexIndex = 0; vertexIndex < paddedCount; vertexIndex += VOLUME_POLYGON_SIMD_WIDTH) {
+    __m256 x = _mm256_loadu_ps(xs + vertexIndex);
+    __m256 y = _mm256_loadu_ps(ys + vertexIndex);
+    __m256 dots = _mm256_fmadd_ps(x, dx, _mm256_mul_ps(y, dy));
+    __m256 isGreater = _mm256_cmp_ps(dots, maxDots, _CMP_GT_OQ);
+    maxDots = _mm256_blendv_ps(maxDots, dots, isGreater);
+    maxIndices = _mm256_castps_si256(
+        _mm256_blendv_ps(_mm256_castsi256_ps(maxIndices), _mm256_castsi256_ps(indices), isGreater));
+    indices = _mm256_add_epi32(indices, step);
+  }
+
+  f32 laneDots[VOLUME_POLYGON_SIMD_WIDTH];
+  u32 laneIndices[VOLUME_POLYGON_SIMD_WIDTH];
+  _mm256_storeu_ps(laneDots, maxDots);
+  _mm256_storeu_si256((__m256i *)laneIndices, maxIndices);
+
+  u32 maxIndex = laneIndices[0];
+  f32 maxDot = laneDots[0];
+  for (u32 lane = 1; lane < VOLUME_POLYGON_SIMD_WIDTH; lane++) {
+    if (laneDots[lane] > maxDot || (laneDots[lane] == maxDot && laneIndices[lane] < maxIndex)) {
+      maxDot = laneDots[lane];
+      maxIndex = laneIndices[lane];
+    }
+  }
+#else
+  u32 maxIndex = 0;
+  f32 maxDot = F32_LOWEST;
+  for (u32 vertexIndex = 0; vertexIndex < paddedCount; vertexIndex++) {
+    f32 dot = xs[vertexIndex] * direction.x + ys[vertexIndex] * direction.y;
+    if (dot > maxDot) {
+      maxDot = dot;
+      maxIndex = vertexIndex;
+    }
+  }
+#endif
+
+  debug_assert(maxIndex < vertexCount);
+  return maxIndex;
+}
+
+/*
+ * Area, centroid and moment of inertia about centroid per unit mass of
+ * convex polygon with counter clockwise verticies.
+ */
+static void
+PolygonComputeMass(u32 vertexCount, v2 *verticies, f32 *area, v2 *centroid, f32 *unitInertia)
+{
+  /*
+   * Polygon is split into triangles fanning out from first vertex s, which
+   * keeps numbers small for polygons far from origin. For triangle with
+   * edges e₁ = vᵢ - s, e₂ = vᵢ₊₁ - s:
+   *   A = ½ (e₁ × e₂)
+   *   c = (e₁ + e₂) / 3
+   *   I = (e₁ × e₂) / 12 (e₁ₓ² + e₁ₓe₂ₓ + e₂ₓ² + e₁ᵧ² + e₁ᵧe₂ᵧ + e₂ᵧ²)
+   * where I is about s with unit density. Sums are moved to centroid by
+   * parallel axis theorem.
+   *   I_c = I_s - A |c|²
+   * see: Box2D b2ComputePolygonMass()
+   */
+  v2 origin = verticies[0];
+  f32 totalArea = 0.0f;
+  v2 center = V2(0.0f, 0.0f);
+  f32 inertia = 0.0f;
+  for (u32 vertexIndex = 1; vertexIndex + 1 < vertexCount; vertexIndex++) {
+    v2 e1 = v2_sub(verticies[vertexIndex], origin);
+    v2 e2 = v2_sub(verticies[vertexIndex + 1], origin);
+    f32 D = v2_cross(e1, e2);
+
+    f32 triangleArea = 0.5f * D;
+    totalArea += triangleArea;
+    v2_add_ref(&center, v2_scale(v2_add(e1, e2), triangleArea / 3.0f));
+
+    f32 intx2 = e1.x * e1.x + e2.x * e1.x + e2.x * e2.x;
+    f32 inty2 = e1.y * e1.y + e2.y * e1.y + e2.y * e2.y;
+    inertia += (D / 12.0f) * (intx2 + inty2);
+  }
+  debug_assert(totalArea > 0.0f && "polygon must be counter clockwise and not degenerate");
+  center = v2_scale(center, 1.0f / totalArea);
+
+  *area = totalArea;
+  *centroid = v2_add(origin, center);
+  *unitInertia = (inertia - totalArea * v2_length_square(center)) / totalArea;
+}
+
+/* @param verticies relative to centroid */
+static f32
+PolygonComputeBoundingRadius(u32 vertexCount, v2 *verticies)
+{
+  f32 maxDistanceSquare = 0.0f;
+  for (u32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
+    f32 distanceSquare = v2_length_square(verticies[vertexIndex]);
+    if (distanceSquare > maxDistanceSquare)
+      maxDistanceSquare = distanceSquare;
+  }
+  return SquareRoot(maxDistanceSquare);
+}
+
+/*
+ * Does a, b, c turn left, with b further than weld distance from line ac.
+ * Distance of b from line is
+ *   -(c - a) × (b - a) / |c - a|
+ */
+static b8
+IsConvexTurn(v2 a, v2 b, v2 c)
+{
+  v2 ac = v2_sub(c, a);
+  return v2_cross(ac, v2_sub(b, a)) < -VOLUME_POLYGON_WELD_DISTANCE * v2_length(ac);
+}
+
+/*
+ * Convex hull by Andrew's monotone chain. Verticies are sorted by x, then
+ * lower and upper hull are built by dropping verticies that do not turn
+ * left. Verticies within VOLUME_POLYGON_WELD_DISTANCE of each other are
+ * welded first, and verticies within it of line through their neighbours
+ * count as collinear and are dropped.
+ * see: https://en.wikibooks.org/wiki/Algorithm_Implementation/Geometry/Convex_hull/Monotone_chain
+ *
+ * @param hull receives at most vertexCount verticies, counter clockwise
+ * @return hull vertex count, 0 when verticies have no area or there are more
+ *         than VOLUME_POLYGON_VERTEX_MAX of them
+ */
+static u32
+ConvexHull(u32 vertexCount, v2 *verticies, v2 *hull)
+{
+  // work buffers are on stack, sized for VOLUME_POLYGON_VERTEX_MAX
+  if (vertexCount > VOLUME_POLYGON_VERTEX_MAX)
+    return 0;
+
+  // weld, then insertion sort by x then y
+  v2 points[VOLUME_POLYGON_VERTEX_MAX];
+  u32 pointCount = 0;
+  for (u32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
+    v2 vertex = verticies[vertexIndex];
+    b8 isWelded = 0;
+    for (u32 pointIndex = 0; pointIndex < pointCount; pointIndex++) {
+      if (v2_length_square(v2_sub(points[pointIndex], vertex)) < Square(VOLUME_POLYGON_WELD_DISTANCE)) {
+        isWelded = 1;
+        break;
+      }
+    }
+    if (isWelded)
+      continue;
+
+    u32 insertIndex = pointCount;
+    while (insertIndex > 0 && (points[insertIndex - 1].x > vertex.x ||
+                               (points[insertIndex - 1].x == vertex.x && points[insertIndex - 1].y > vertex.y))) {
+      points[insertIndex] = points[insertIndex - 1];
+      insertIndex--;
+    }
+    points[insertIndex] = vertex;
+    pointCount++;
+  }
+
+  if (pointCount < 3)
+    return 0;
+
+  /* Chain holds lower hull left to right, then upper hull right to left.
+   * Vertex that does not make left turn towards next point is dropped.
+   */
+  v2 chain[VOLUME_POLYGON_VERTEX_MAX * 2];
+  u32 chainCount = 0;
+  for (u32 pointIndex = 0; pointIndex < pointCount; pointIndex++) {
+    v2 point = points[pointIndex];
+    while (chainCount >= 2 && !IsConvexTurn(chain[chainCount - 2], chain[chainCount - 1], point))
+      chainCount--;
+    chain[chainCount] = point;
+    chainCount++;
+  }
+  u32 lowerCount = chainCount + 1;
+  for (u32 pointIndex = pointCount - 1; pointIndex-- > 0;) {
+    v2 point = points[pointIndex];
+    while (chainCount >= lowerCount && !IsConvexTurn(chain[chainCount - 2], chain[chainCount - 1], point))
+      chainCount--;
+    chain[chainCount] = point;
+    chainCount++;
+  }
+  // last point is first point again
+  chainCount--;
+
+  // first point is never dropped by chain, check it against its neighbours
+  u32 startIndex = 0;
+  if (chainCount >= 3 && !IsConvexTurn(chain[chainCount - 1], chain[0], chain[1]))
+    startIndex = 1;
+
+  u32 hullCount = chainCount - startIndex;
+  if (hullCount < 3)
+    return 0;
+
+  for (u32 hullIndex = 0; hullIndex < hullCount; hullIndex++)
+    hull[hullIndex] = chain[startIndex + hullIndex];
+  return hullCount;
+}
+
 static volume *
 VolumePolygon(memory_arena *memory, u32 vertexCount, v2 verticies[static vertexCount])
 {
+  // minimal verticies keep support searches short
+  v2 hull[VOLUME_POLYGON_VERTEX_MAX];
+  vertexCount = ConvexHull(vertexCount, verticies, hull);
+  if (vertexCount < 3)
+    return 0;
+  verticies = hull;
+
   volume_polygon *polygon;
   volume *volume = Volume(memory, VOLUME_TYPE_POLYGON, sizeof(*polygon));
   if (!volume)
@@ -66,12 +304,35 @@ VolumePolygon(memory_arena *memory, u32 vertexCount, v2 verticies[static vertexC
 
   polygon = VolumeGetPolygon(volume);
 
+  PolygonComputeMass(vertexCount, verticies, &polygon->area, &polygon->centroid, &polygon->unitInertia);
+
   polygon->vertexCount = vertexCount;
   v2 *allocatedVerticies = MemoryArenaPush(memory, sizeof(*allocatedVerticies) * polygon->vertexCount);
   for (u32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
-    allocatedVerticies[vertexIndex] = verticies[vertexIndex];
+    allocatedVerticies[vertexIndex] = v2_sub(verticies[vertexIndex], polygon->centroid);
   }
   polygon->verticies = allocatedVerticies;
+  polygon->boundingRadius = PolygonComputeBoundingRadius(vertexCount, allocatedVerticies);
+
+  // verticies are counter clockwise, outward normal is on right side of edge
+  v2 *allocatedNormals = MemoryArenaPush(memory, sizeof(*allocatedNormals) * polygon->vertexCount);
+  for (u32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
+    v2 edge = v2_sub(allocatedVerticies[(vertexIndex + 1) % vertexCount], allocatedVerticies[vertexIndex]);
+    allocatedNormals[vertexIndex] = v2_normalize(V2(edge.y, -edge.x));
+  }
+  polygon->normals = allocatedNormals;
+
+  // padding repeats first vertex, so it never becomes support over real one
+  u32 paddedCount = PolygonGetPaddedCount(vertexCount);
+  f32 *xs = MemoryArenaPushAligned(memory, sizeof(*xs) * paddedCount, 32);
+  f32 *ys = MemoryArenaPushAligned(memory, sizeof(*ys) * paddedCount, 32);
+  for (u32 vertexIndex = 0; vertexIndex < paddedCount; vertexIndex++) {
+    v2 vertex = allocatedVerticies[vertexIndex < vertexCount ? vertexIndex : 0];
+    xs[vertexIndex] = vertex.x;
+    ys[vertexIndex] = vertex.y;
+  }
+  polygon->xs = xs;
+  polygon->ys = ys;
 
   return volume;
 }
@@ -91,6 +352,33 @@ VolumeBox(memory_arena *memory, f32 width, f32 height)
   return volume;
 }
 
+static volume *
+VolumeTriangle(memory_arena *memory, v2 a, v2 b, v2 c)
+{
+  // also rejects clockwise verticies
+  if (!IsConvexTurn(a, b, c))
+    return 0;
+
+  volume_triangle *triangle;
+  volume *volume = Volume(memory, VOLUME_TYPE_TRIANGLE, sizeof(*triangle));
+  if (!volume)
+    return 0;
+
+  triangle = VolumeGetTriangle(volume);
+  v2 verticies[] = {a, b, c};
+  PolygonComputeMass(ARRAY_COUNT(verticies), verticies, &triangle->area, &triangle->centroid, &triangle->unitInertia);
+
+  for (u32 vertexIndex = 0; vertexIndex < 3; vertexIndex++)
+    triangle->verticies[vertexIndex] = v2_sub(verticies[vertexIndex], triangle->centroid);
+  triangle->boundingRadius = PolygonComputeBoundingRadius(3, triangle->verticies);
+  for (u32 vertexIndex = 0; vertexIndex < 3; vertexIndex++) {
+    v2 edge = v2_sub(triangle->verticies[(vertexIndex + 1) % 3], triangle->verticies[vertexIndex]);
+    triangle->normals[vertexIndex] = v2_normalize(V2(edge.y, -edge.x));
+  }
+
+  return volume;
+}
+
 static inline f32
 VolumeCircleGetMomentOfInertia(volume *volume, f32 mass)
 {
@@ -133,6 +421,13 @@ VolumeGetMomentOfInertia(volume *volume, f32 mass)
   case VOLUME_TYPE_BOX: {
     return VolumeBoxGetMomentOfInertia(volume, mass);
   } break;
+  case VOLUME_TYPE_POLYGON: {
+    // precomputed in VolumePolygon()
+    return mass * VolumeGetPolygon(volume)->unitInertia;
+  } break;
+  case VOLUME_TYPE_TRIANGLE: {
+    return mass * VolumeGetTriangle(volume)->unitInertia;
+  } break;
 
   default: {
     breakpoint("don't know how to calculate moment of inertia for this volume");
@@ -141,6 +436,201 @@ VolumeGetMomentOfInertia(volume *volume, f32 mass)
   }
 }
 
+static u32
+VolumeHash(volume *volume)
+{
+  /* FNV-1a over type and parameters
+   * see: https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+   */
+  f32 *values = 0;
+  u64 valueCount = 0;
+  switch (volume->type) {
+  case VOLUME_TYPE_CIRCLE: {
+    values = &VolumeGetCircle(volume)->radius;
+    valueCount = 1;
+  } break;
+  case VOLUME_TYPE_BOX: {
+    volume_box *box = VolumeGetBox(volume);
+    static_assert(sizeof(*box) == 2 * sizeof(f32));
+    values = &box->width;
+    valueCount = 2;
+  } break;
+  case VOLUME_TYPE_POLYGON: {
+    volume_polygon *polygon = VolumeGetPolygon(volume);
+    values = polygon->verticies[0].e;
+    valueCount = 2 * polygon->vertexCount;
+  } break;
+  case VOLUME_TYPE_TRIANGLE: {
+    volume_triangle *triangle = VolumeGetTriangle(volume);
+    values = triangle->verticies[0].e;
+    valueCount = 2 * ARRAY_COUNT(triangle->verticies);
+  } break;
+  default: {
+    breakpoint("don't know how to hash this volume");
+  } break;
+  }
+
+  u32 hash = 2166136261u;
+  hash = (hash ^ (u32)volume->type) * 16777619u;
+  for (u64 valueIndex = 0; valueIndex < valueCount; valueIndex++) {
+    // IsVolumeEqual() compares with ==, -0 and 0 must hash the same
+    f32 value = values[valueIndex] + 0.0f;
+    u8 bytes[sizeof(value)];
+    memcpy(bytes, &value, sizeof(value));
+    for (u64 byteIndex = 0; byteIndex < sizeof(bytes); byteIndex++)
+      hash = (hash ^ bytes[byteIndex]) * 16777619u;
+  }
+  return hash;
+}
+
+static b8
+IsVolumeEqual(volume *a, volume *b)
+{
+  if (a->type != b->type)
+    return 0;
+
+  switch (a->type) {
+  case VOLUME_TYPE_CIRCLE: {
+    return VolumeGetCircle(a)->radius == VolumeGetCircle(b)->radius;
+  } break;
+  case VOLUME_TYPE_BOX: {
+    volume_box *boxA = VolumeGetBox(a);
+    volume_box *boxB = VolumeGetBox(b);
+    return boxA->width == boxB->width && boxA->height == boxB->height;
+  } break;
+  case VOLUME_TYPE_POLYGON: {
+    volume_polygon *polygonA = VolumeGetPolygon(a);
+    volume_polygon *polygonB = VolumeGetPolygon(b);
+    // same shape at different place is different volume, centroids tell where it was given
+    if (polygonA->vertexCount != polygonB->vertexCount || polygonA->centroid.x != polygonB->centroid.x ||
+        polygonA->centroid.y != polygonB->centroid.y)
+      return 0;
+    for (u32 vertexIndex = 0; vertexIndex < polygonA->vertexCount; vertexIndex++) {
+      v2 vertexA = polygonA->verticies[vertexIndex];
+      v2 vertexB = polygonB->verticies[vertexIndex];
+      if (vertexA.x != vertexB.x || vertexA.y != vertexB.y)
+        return 0;
+    }
+    return 1;
+  } break;
+  case VOLUME_TYPE_TRIANGLE: {
+    volume_triangle *triangleA = VolumeGetTriangle(a);
+    volume_triangle *triangleB = VolumeGetTriangle(b);
+    if (triangleA->centroid.x != triangleB->centroid.x || triangleA->centroid.y != triangleB->centroid.y)
+      return 0;
+    for (u32 vertexIndex = 0; vertexIndex < 3; vertexIndex++) {
+      v2 vertexA = triangleA->verticies[vertexIndex];
+      v2 vertexB = triangleB->verticies[vertexIndex];
+      if (vertexA.x != vertexB.x || vertexA.y != vertexB.y)
+        return 0;
+    }
+    return 1;
+  } break;
+  default: {
+    breakpoint("don't know how to compare this volume");
+    return 0;
+  } break;
+  }
+}
+
+static void
+VolumeRegistryInit(volume_registry *registry, memory_arena memory)
+{
+  bzero(registry, sizeof(*registry));
+  registry->memory = memory;
+  registry->volumeCount = 1; // index 0 means null volume
+}
+
+/*
+ * Registers volume that is just created at end of registry memory.
+ * If same volume is already registered, newly created one is given back
+ * to memory. So is volume that does not fit in full registry.
+ * @return registered volume, 0 when registry is full
+ * Time Complexity: If there is no hash collision O(1),
+ *                  If there is k number of hash collisions O(k)
+ */
+static volume *
+VolumeRegistryIntern(volume_registry *registry, memory_temp *creation, volume *created)
+{
+  // volume index is stored in u16 slot
+  static_assert(VOLUME_REGISTRY_MAX <= U16_MAX);
+  u32 hashMask = VOLUME_REGISTRY_SLOT_COUNT - 1;
+  u32 slotIndex = VolumeHash(created) & hashMask;
+  for (;;) {
+    u16 volumeIndex = registry->slots[slotIndex];
+    if (volumeIndex == 0)
+      break;
+
+    volume *registered = registry->volumes[volumeIndex];
+    if (IsVolumeEqual(registered, created)) {
+      MemoryTempEnd(creation);
+      return registered;
+    }
+
+    slotIndex = (slotIndex + 1) & hashMask;
+  }
+
+  if (registry->volumeCount == VOLUME_REGISTRY_MAX) {
+    MemoryTempEnd(creation);
+    return 0;
+  }
+
+  u32 volumeIndex = registry->volumeCount;
+  registry->volumeCount++;
+
+  created->index = volumeIndex;
+  registry->volumes[volumeIndex] = created;
+  registry->slots[slotIndex] = (u16)volumeIndex;
+  return created;
+}
+
+static volume *
+VolumeRegistryCircle(volume_registry *registry, f32 radius)
+{
+  memory_temp creation = MemoryTempBegin(&registry->memory);
+  volume *created = VolumeCircle(creation.arena, radius);
+  return VolumeRegistryIntern(registry, &creation, created);
+}
+
+static volume *
+VolumeRegistryPolygon(volume_registry *registry, u32 vertexCount, v2 verticies[static vertexCount])
+{
+  memory_temp creation = MemoryTempBegin(&registry->memory);
+  volume *created = VolumePolygon(creation.arena, vertexCount, verticies);
+  if (!created) {
+    MemoryTempEnd(&creation);
+    return 0;
+  }
+  return VolumeRegistryIntern(registry, &creation, created);
+}
+
+static volume *
+VolumeRegistryBox(volume_registry *registry, f32 width, f32 height)
+{
+  memory_temp creation = MemoryTempBegin(&registry->memory);
+  volume *created = VolumeBox(creation.arena, width, height);
+  return VolumeRegistryIntern(registry, &creation, created);
+}
+
+static volume *
+VolumeRegistryTriangle(volume_registry *registry, v2 a, v2 b, v2 c)
+{
+  memory_temp creation = MemoryTempBegin(&registry->memory);
+  volume *created = VolumeTriangle(creation.arena, a, b, c);
+  if (!created) {
+    MemoryTempEnd(&creation);
+    return 0;
+  }
+  return VolumeRegistryIntern(registry, &creation, created);
+}
+
+static volume *
+VolumeRegistryGet(volume_registry *registry, u32 index)
+{
+  debug_assert(index != 0 && index < registry->volumeCount);
+  return registry->volumes[index];
+}
+
 static b8
 IsEntityStatic(struct entity *entity)
 {
@@ -153,6 +643,46 @@ IsEntityStatic(struct entity *entity)
 #endif
 }
 
+static void
+EntityUpdateRotation(struct entity *entity)
+{
+  entity->rotationMatrix = m2_rotation(entity->rotation);
+}
+
+static b8
+IsEntityAwake(struct entity *entity)
+{
+  return !IsEntityStatic(entity) && !entity->isSleeping;
+}
+
+static void
+EntityWake(struct entity *entities, u32 entityIndex)
+{
+  debug_assert(entities[entityIndex].isSleeping);
+  // island sleeps and wakes as whole, so ring is intact until here
+  u32 index = entityIndex;
+  do {
+    struct entity *entity = entities + index;
+    entity->isSleeping = 0;
+    entity->sleepTime = 0.0f;
+    index = entity->sleepIslandNext;
+  } while (index != entityIndex);
+}
+
+static b8
+ShouldEntitiesCollide(struct entity *entityA, struct entity *entityB)
+{
+  if (IsEntityStatic(entityA) && IsEntityStatic(entityB))
+    return 0;
+
+  collision_filter *filterA = &entityA->filter;
+  collision_filter *filterB = &entityB->filter;
+  if (filterA->group != 0 && filterA->group == filterB->group)
+    return filterA->group > 0;
+
+  return (filterA->categoryBits & filterB->maskBits) != 0 && (filterB->categoryBits & filterA->maskBits) != 0;
+}
+
 static v2
 GenerateWeightForce(struct entity *entity)
 {
@@ -279,48 +809,6 @@ GenerateDampingForce(struct entity *entity, f32 k)
   return dampingForce;
 }
 
-static void
-ApplyImpulse(struct entity *a, v2 j)
-{
-  /* # MOMENTUM
-   * Momentum p is a measurement of mass in motion
-   *
-   *   p = m v
-   *   where m is mass
-   *         v is velocity
-   *
-   * As objects collide, they transfer some of their momentum to other
-   * but total momentum of system should always be constant.
-   * a.k.a. conservation of momentum
-   *
-   *    m₁v₁ + m₂v₂ = m₁v'₁ + m₂v'₂
-   *
-   * NOTE: We assume mass does not change
-   *
-   * # THE IMPULSE METHOD
-   * Impulse J is change in momentum by performing a direct change in velocity
-   *
-   *   J = F ∆t
-   *     = ∆p
-   *     = mv' - mv
-   *     = m ∆v
-   *
-   * If we solve for force over time we get the same result. This means
-   * if we apply force over time object will get momentum.
-   *
-   *   J = F ∆t
-   *     = m a ∆t
-   *     = m (∆v/∆t) ∆t
-   *     = m ∆v
-   *
-   *   ∆v = J / m
-   */
-  if (IsEntityStatic(a))
-    return;
-
-  v2_add_ref(&a->velocity, v2_scale(j, a->invMass));
-}
-
 static v2
 FindFurthestPoint(struct entity *entity, v2 direction)
 {
@@ -335,28 +823,32 @@ FindFurthestPoint(struct entity *entity, v2 direction)
 
   case VOLUME_TYPE_BOX: {
     volume_box *box = VolumeGetBox(volume);
+    // search in box's local space, then rotate result back to world
+    v2 localDirection = m2_mul_transpose_v2(entity->rotationMatrix, direction);
     v2 halfSize = V2(box->width * 0.5f, box->height * 0.5f);
-    v2 pointInDirection = v2_hadamard(halfSize, V2(SignOf(direction.x), SignOf(direction.y)));
-    return v2_add(entity->position, pointInDirection);
+    v2 pointInDirection = v2_hadamard(halfSize, V2(SignOf(localDirection.x), SignOf(localDirection.y)));
+    return v2_add(entity->position, m2_mul_v2(entity->rotationMatrix, pointInDirection));
   } break;
 
   case VOLUME_TYPE_POLYGON: {
     volume_polygon *polygon = VolumeGetPolygon(volume);
-    v2 *verticies = polygon->verticies;
-    u32 vertexCount = polygon->vertexCount;
-
-    v2 maxPoint = verticies[0];
-    f32 maxDistance = v2_dot(maxPoint, direction);
-    for (u32 vertexIndex = 1; vertexIndex < vertexCount; vertexIndex++) {
-      v2 point = verticies[vertexIndex];
-      f32 distance = v2_dot(point, direction);
-      if (distance > maxDistance) {
-        maxPoint = point;
-        maxDistance = distance;
-      }
+    v2 localDirection = m2_mul_transpose_v2(entity->rotationMatrix, direction);
+    u32 maxIndex = PolygonSupportIndex(polygon->xs, polygon->ys, polygon->vertexCount, localDirection);
+    v2 maxPoint = polygon->verticies[maxIndex];
+
+    return v2_add(entity->position, m2_mul_v2(entity->rotationMatrix, maxPoint));
+  } break;
+
+  case VOLUME_TYPE_TRIANGLE: {
+    volume_triangle *triangle = VolumeGetTriangle(volume);
+    v2 localDirection = m2_mul_transpose_v2(entity->rotationMatrix, direction);
+    v2 maxPoint = triangle->verticies[0];
+    for (u32 vertexIndex = 1; vertexIndex < 3; vertexIndex++) {
+      if (v2_dot(triangle->verticies[vertexIndex], localDirection) > v2_dot(maxPoint, localDirection))
+        maxPoint = triangle->verticies[vertexIndex];
     }
 
-    return v2_add(entity->position, maxPoint);
+    return v2_add(entity->position, m2_mul_v2(entity->rotationMatrix, maxPoint));
   } break;
 
   default: {
@@ -366,600 +858,2300 @@ FindFurthestPoint(struct entity *entity, v2 direction)
   }
 }
 
-static v2
-Support(struct entity *a, struct entity *b, v2 direction)
-{
-  return v2_sub(FindFurthestPoint(a, direction), FindFurthestPoint(b, v2_neg(direction)));
-}
+/* Verticies and normals of polygon or triangle volume, in its local space */
+typedef struct local_polygon {
+  v2 *verticies;
+  v2 *normals;
+  u32 count;
+} local_polygon;
 
-static b8
-IsSameDirection(v3 direction, v3 ao)
+static local_polygon
+VolumeGetLocalPolygon(volume *volume)
 {
-  return v3_dot(direction, ao) > 0.0f;
-}
+  switch (volume->type) {
+  case VOLUME_TYPE_POLYGON: {
+    volume_polygon *polygon = VolumeGetPolygon(volume);
+    return (local_polygon){polygon->verticies, polygon->normals, polygon->vertexCount};
+  } break;
 
-static b8
-CollisionDetect(struct entity *entityA, struct entity *entityB, contact *contact)
-{
-  if (entityA->volume->type > entityB->volume->type) {
-    struct entity *tmp = entityA;
-    entityA = entityB;
-    entityB = tmp;
+  case VOLUME_TYPE_TRIANGLE: {
+    volume_triangle *triangle = VolumeGetTriangle(volume);
+    return (local_polygon){triangle->verticies, triangle->normals, 3};
+  } break;
+
+  default: {
+    breakpoint("volume has no verticies");
+    return (local_polygon){};
+  } break;
   }
+}
 
-  b8 isColliding = 0;
+/*
+ * Box or polygon in world space. Verticies are counter clockwise, normal i is
+ * outward normal of edge from vertex i to vertex i+1.
+ */
+typedef struct world_polygon {
+  v2 verticies[VOLUME_POLYGON_VERTEX_MAX];
+  v2 normals[VOLUME_POLYGON_VERTEX_MAX];
+  // verticies in SoA layout for PolygonSupportIndex()
+  f32 xs[VOLUME_POLYGON_VERTEX_MAX];
+  f32 ys[VOLUME_POLYGON_VERTEX_MAX];
+  u32 count;
+} world_polygon;
 
-  switch (entityA->volume->type | entityB->volume->type) {
-  case VOLUME_TYPE_CIRCLE | VOLUME_TYPE_CIRCLE: {
-    volume_circle *circleA = VolumeGetCircle(entityA->volume);
-    volume_circle *circleB = VolumeGetCircle(entityB->volume);
+static void
+EntityGetPolygon(struct entity *entity, world_polygon *polygon)
+{
+  volume *volume = entity->volume;
+  v2 position = entity->position;
+  m2 rotation = entity->rotationMatrix;
 
-    v2 positionA = entityA->position;
-    v2 positionB = entityB->position;
+  switch (volume->type) {
+  case VOLUME_TYPE_BOX: {
+    volume_box *box = VolumeGetBox(volume);
+    v2 halfSize = V2(box->width * 0.5f, box->height * 0.5f);
+    v2 localVerticies[] = {
+        V2(-halfSize.x, -halfSize.y),
+        V2(halfSize.x, -halfSize.y),
+        V2(halfSize.x, halfSize.y),
+        V2(-halfSize.x, halfSize.y),
+    };
+    v2 localNormals[] = {
+        V2(0.0f, -1.0f),
+        V2(1.0f, 0.0f),
+        V2(0.0f, 1.0f),
+        V2(-1.0f, 0.0f),
+    };
+    static_assert(ARRAY_COUNT(localVerticies) == ARRAY_COUNT(localNormals));
+    polygon->count = ARRAY_COUNT(localVerticies);
+    for (u32 vertexIndex = 0; vertexIndex < polygon->count; vertexIndex++) {
+      polygon->verticies[vertexIndex] = v2_add(position, m2_mul_v2(rotation, localVerticies[vertexIndex]));
+      polygon->normals[vertexIndex] = m2_mul_v2(rotation, localNormals[vertexIndex]);
+    }
+  } break;
 
-    v2 distance = v2_sub(positionB, positionA);
-    isColliding = v2_length_square(distance) <= Square(circleA->radius + circleB->radius);
-    if (!isColliding)
-      return isColliding;
+  case VOLUME_TYPE_POLYGON:
+  case VOLUME_TYPE_TRIANGLE: {
+    local_polygon localPolygon = VolumeGetLocalPolygon(volume);
+    debug_assert(localPolygon.count <= VOLUME_POLYGON_VERTEX_MAX);
+    polygon->count = localPolygon.count;
+    for (u32 vertexIndex = 0; vertexIndex < polygon->count; vertexIndex++) {
+      polygon->verticies[vertexIndex] = v2_add(position, m2_mul_v2(rotation, localPolygon.verticies[vertexIndex]));
+      polygon->normals[vertexIndex] = m2_mul_v2(rotation, localPolygon.normals[vertexIndex]);
+    }
+  } break;
 
-    contact->normal = v2_normalize(distance);
-    contact->start = v2_sub(positionB, v2_scale(contact->normal, circleB->radius));
-    contact->end = v2_add(positionA, v2_scale(contact->normal, circleA->radius));
-    contact->depth = v2_length(v2_sub(contact->end, contact->start));
-  } break;
-
-  case VOLUME_TYPE_BOX | VOLUME_TYPE_BOX: {
-#if 0
-    /* see:
-     * - https://www.youtube.com/watch?v=MDusDn8oTSE "GJK Algorithm Explanation & Implementation"
-     *   https://winter.dev/articles/gjk-algorithm
-     * - https://www.youtube.com/watch?v=Qupqu1xe7Io "Implementing GJK - 2006"
-     */
-    // get initial support point in any direction
-    v2 support = Support(entityA, entityB, V2(1.0f, 0.0f));
-
-    // simplex is array of points, max of 3 for 2D
-    v2 points[3];
-    points[0] = support;
-    u32 pointCount = 1;
-
-    // new direction is towards origin
-    v2 direction = v2_neg(support);
-
-    while (!isColliding) {
-      support = Support(entityA, entityB, direction);
-      if (v2_dot(support, direction) <= 0) {
-        // did not pass origin in search direction
-        // no collision / no intersection
-        isColliding = 0;
-        return isColliding;
-      }
+  default: {
+    breakpoint("volume is not a polygon");
+    polygon->count = 0;
+  } break;
+  }
 
-      points[pointCount] = support;
-      pointCount++;
-      debug_assert(pointCount <= ARRAY_COUNT(points));
+  static_assert(VOLUME_POLYGON_VERTEX_MAX % VOLUME_POLYGON_SIMD_WIDTH == 0);
+  u32 paddedCount = PolygonGetPaddedCount(polygon->count);
+  for (u32 vertexIndex = 0; vertexIndex < paddedCount; vertexIndex++) {
+    v2 vertex = polygon->verticies[vertexIndex < polygon->count ? vertexIndex : 0];
+    polygon->xs[vertexIndex] = vertex.x;
+    polygon->ys[vertexIndex] = vertex.y;
+  }
+}
 
-      switch (pointCount) {
-      case 2: {
-        // when simplex is line segment
-        v3 a = {.xy = points[1]};
-        v3 b = {.xy = points[0]};
+/*
+ * Finds edge whose normal is most aligned with direction.
+ * @param alignment dot product of edge normal and direction
+ */
+static u32
+PolygonFindEdgeAlong(world_polygon *polygon, v2 direction, f32 *alignment)
+{
+  u32 maxEdgeIndex = 0;
+  f32 maxAlignment = F32_LOWEST;
+  for (u32 edgeIndex = 0; edgeIndex < polygon->count; edgeIndex++) {
+    f32 edgeAlignment = v2_dot(polygon->normals[edgeIndex], direction);
+    if (edgeAlignment > maxAlignment) {
+      maxAlignment = edgeAlignment;
+      maxEdgeIndex = edgeIndex;
+    }
+  }
 
-        v3 ab = v3_sub(b, a);
-        v3 ao = v3_neg(a);
+  *alignment = maxAlignment;
+  return maxEdgeIndex;
+}
 
-        v2 abPerp = v3_cross(v3_cross(ab, ao), ab).xy;
-        if (v2_length_square(abPerp) == 0.0f) {
-          isColliding = 1;
-        } else {
-          direction = abPerp;
-        }
+typedef struct clip_vertex {
+  v2 point;
+  u32 id; // incident vertex index or CONTACT_ID_CLIPPED()
+} clip_vertex;
+
+/*
+ * Keeps part of segment behind plane.
+ *   n∙p - offset <= 0
+ * @param clipId id of point created where segment crosses plane
+ * @return number of points written, 2 unless segment is entirely in front
+ */
+static u32
+ClipSegment(clip_vertex out[static 2], clip_vertex in[static 2], v2 planeNormal, f32 planeOffset, u32 clipId)
+{
+  u32 count = 0;
+  f32 distance0 = v2_dot(planeNormal, in[0].point) - planeOffset;
+  f32 distance1 = v2_dot(planeNormal, in[1].point) - planeOffset;
 
-      } break;
-      case 3: {
-        // when simplex forms triangle
-        v3 a = {.xy = points[2]}; // new point, that just got added
-        v3 b = {.xy = points[1]};
-        v3 c = {.xy = points[0]};
-
-        v3 ab = v3_sub(b, a);
-        v3 ac = v3_sub(c, a);
-        v3 ao = v3_neg(a);
-
-        v3 abcNormal = v3_cross(ab, ac);
-        v3 abNormal = v3_cross(ab, abcNormal);
-        v3 acNormal = v3_cross(abcNormal, ac);
-
-        if (IsSameDirection(abNormal, ao)) {
-          direction = v3_cross(v3_cross(ab, ao), ab).xy;
-
-          points[0] = b.xy;
-          points[1] = a.xy;
-          pointCount = 2;
-        } else if (IsSameDirection(acNormal, ao)) {
-          direction = v3_cross(v3_cross(ac, ao), ac).xy;
-
-          points[0] = c.xy;
-          points[1] = a.xy;
-          pointCount = 2;
-        } else {
-          // must be inside of triangle
-          isColliding = 1;
-          break;
-        }
-      } break;
-      }
+  if (distance0 <= 0.0f) {
+    out[count] = in[0];
+    count++;
+  }
+  if (distance1 <= 0.0f) {
+    out[count] = in[1];
+    count++;
+  }
+
+  // points on different sides, point where segment crosses plane
+  if (distance0 * distance1 < 0.0f) {
+    f32 t = distance0 / (distance0 - distance1);
+    out[count].point = v2_add(in[0].point, v2_scale(v2_sub(in[1].point, in[0].point), t));
+    out[count].id = clipId;
+    count++;
+  }
+
+  return count;
+}
+
+/*
+ * Support vertex by hill climbing from hint vertex. Along convex polygon v∙d
+ * rises up to support vertex and falls after it, so walking towards better
+ * neighbor ends at support vertex. Polygon's ring of verticies is its
+ * adjacency, neighbors of vertex are previous and next vertex.
+ * With good hint, eg. support from previous frame, only few verticies are
+ * visited.
+ */
+static u32
+PolygonSupportIndexFrom(v2 *verticies, u32 vertexCount, v2 direction, u32 hintIndex)
+{
+  debug_assert(hintIndex < vertexCount);
+  u32 index = hintIndex;
+  f32 dot = v2_dot(verticies[index], direction);
+
+  // pick direction of walk once, other side can only get worse
+  u32 step = 1;
+  u32 next = (index + step) % vertexCount;
+  f32 nextDot = v2_dot(verticies[next], direction);
+  if (nextDot <= dot) {
+    step = vertexCount - 1;
+    next = (index + step) % vertexCount;
+    nextDot = v2_dot(verticies[next], direction);
+  }
+
+  for (u32 visited = 0; nextDot > dot && visited < vertexCount; visited++) {
+    index = next;
+    dot = nextDot;
+    next = (index + step) % vertexCount;
+    nextDot = v2_dot(verticies[next], direction);
+  }
+
+  return index;
+}
+
+/*
+ * Small polygons are scanned whole with SIMD, large polygons are climbed.
+ * @param hintIndex vertex to start climbing from
+ */
+static u32
+WorldPolygonSupportIndex(world_polygon *polygon, v2 direction, u32 hintIndex)
+{
+  if (polygon->count < VOLUME_POLYGON_HILL_CLIMB_MIN)
+    return PolygonSupportIndex(polygon->xs, polygon->ys, polygon->count, direction);
+  return PolygonSupportIndexFrom(polygon->verticies, polygon->count, direction, hintIndex % polygon->count);
+}
+
+/*
+ * Separation of B from edge of A, distance of deepest vertex of B in front
+ * of the edge.
+ *   separation = min (n ∙ (v_B - v_edge))
+ * Positive separation means edge normal is a separating axis.
+ * @param deepestIndex in: hint to start search from, out: deepest vertex of B
+ */
+static f32
+PolygonEdgeSeparation(world_polygon *a, u32 edgeIndex, world_polygon *b, u32 *deepestIndex)
+{
+  v2 n = a->normals[edgeIndex];
+  f32 edgeOffset = v2_dot(n, a->verticies[edgeIndex]);
+
+  // deepest vertex of B is furthest against normal
+  *deepestIndex = WorldPolygonSupportIndex(b, v2_neg(n), *deepestIndex);
+  f32 separation = v2_dot(n, b->verticies[*deepestIndex]);
+
+  return separation - edgeOffset;
+}
+
+/*
+ * Finds edge of A that B penetrates the least. Stops at first separating
+ * axis, most candidate pairs are separated.
+ * Normals of consecutive edges turn one way, so deepest vertex of B moves
+ * one way too. Every edge starts search from deepest vertex of previous edge.
+ * see: Erin Catto - Box2D, b2FindMaxSeparation
+ * @param firstDeepestIndex in: hint for first edge, eg. from previous frame,
+ *                          out: deepest vertex of B against first edge
+ * @param edgeIndex edge with max separation, or first separating edge
+ * @param deepestIndex deepest vertex of B against that edge
+ * @return max separation, positive means A and B do not overlap
+ */
+static f32
+PolygonFindMaxSeparation(world_polygon *a, world_polygon *b, u32 *firstDeepestIndex, u32 *edgeIndex,
+                         u32 *deepestIndex)
+{
+  u32 maxEdgeIndex = 0;
+  u32 maxDeepestIndex = 0;
+  f32 maxSeparation = F32_LOWEST;
+  u32 hintIndex = *firstDeepestIndex;
+  for (u32 edgeAIndex = 0; edgeAIndex < a->count; edgeAIndex++) {
+    f32 separation = PolygonEdgeSeparation(a, edgeAIndex, b, &hintIndex);
+    if (edgeAIndex == 0)
+      *firstDeepestIndex = hintIndex;
+    if (separation > maxSeparation) {
+      maxSeparation = separation;
+      maxEdgeIndex = edgeAIndex;
+      maxDeepestIndex = hintIndex;
+      if (maxSeparation > 0.0f)
+        break;
+    }
+  }
+
+  *edgeIndex = maxEdgeIndex;
+  *deepestIndex = maxDeepestIndex;
+  return maxSeparation;
+}
+
+/*
+ * Builds contact manifold of two polygons by clipping.
+ *
+ * Separating Axis Theorem: polygons overlap only if no edge normal of either
+ * separates them. Reference edge is edge that other polygon penetrates the
+ * least, its normal is collision normal. Incident edge is edge of other
+ * polygon facing it the most. Incident edge is clipped by side planes of
+ * reference edge, points below reference edge are contact points.
+ *
+ * see: Dirk Gregorius - "Robust Contact Creation for Physics Simulation" (GDC 2015)
+ *
+ * @param cache keeps separating edge between frames, may be 0
+ */
+static b8
+CollisionDetectPolygons(struct entity *entityA, struct entity *entityB, pair_cache_entry *cache, contact *contact)
+{
+  world_polygon polygonA;
+  world_polygon polygonB;
+  EntityGetPolygon(entityA, &polygonA);
+  EntityGetPolygon(entityB, &polygonB);
+
+  // axis that separated pair in last frame most likely still does
+  if (cache && cache->hasSeparatingEdge) {
+    u32 edgeIndex = cache->separatingEdge;
+    u32 *deepestIndex = &cache->separatingSupport;
+    f32 separation = cache->isSeparatingEdgeOnB
+                         ? PolygonEdgeSeparation(&polygonB, edgeIndex, &polygonA, deepestIndex)
+                         : PolygonEdgeSeparation(&polygonA, edgeIndex, &polygonB, deepestIndex);
+    if (separation > 0.0f)
+      return 0;
+    cache->hasSeparatingEdge = 0;
+  }
+
+  // search of every edge starts from where it ended in last frame
+  u32 firstDeepestB = cache ? cache->firstSupports[0] : 0;
+  u32 firstDeepestA = cache ? cache->firstSupports[1] : 0;
+
+  u32 edgeA;
+  u32 deepestB;
+  f32 separationA = PolygonFindMaxSeparation(&polygonA, &polygonB, &firstDeepestB, &edgeA, &deepestB);
+  if (cache)
+    cache->firstSupports[0] = firstDeepestB;
+  if (separationA > 0.0f) {
+    if (cache) {
+      cache->hasSeparatingEdge = 1;
+      cache->isSeparatingEdgeOnB = 0;
+      cache->separatingEdge = edgeA;
+      cache->separatingSupport = deepestB;
+    }
+    return 0;
+  }
+
+  u32 edgeB;
+  u32 deepestA;
+  f32 separationB = PolygonFindMaxSeparation(&polygonB, &polygonA, &firstDeepestA, &edgeB, &deepestA);
+  if (cache)
+    cache->firstSupports[1] = firstDeepestA;
+  if (separationB > 0.0f) {
+    if (cache) {
+      cache->hasSeparatingEdge = 1;
+      cache->isSeparatingEdgeOnB = 1;
+      cache->separatingEdge = edgeB;
+      cache->separatingSupport = deepestA;
+    }
+    return 0;
+  }
+
+  // prefer A, so reference does not flip between frames when both are equal
+  const f32 separationTolerance = 0.001f;
+  b8 isFlipped = separationB > separationA + separationTolerance;
+
+  world_polygon *reference = &polygonA;
+  world_polygon *incident = &polygonB;
+  u32 referenceEdge = edgeA;
+  if (isFlipped) {
+    reference = &polygonB;
+    incident = &polygonA;
+    referenceEdge = edgeB;
+  }
+
+  u32 referenceCount = reference->count;
+  v2 edgeStart = reference->verticies[referenceEdge];
+  v2 edgeEnd = reference->verticies[(referenceEdge + 1) % referenceCount];
+  v2 tangent = v2_normalize(v2_sub(edgeEnd, edgeStart));
+  v2 referenceNormal = reference->normals[referenceEdge];
+
+  // incident edge faces reference edge the most
+  f32 incidentAlignment;
+  u32 incidentEdge = PolygonFindEdgeAlong(incident, v2_neg(referenceNormal), &incidentAlignment);
+  u32 incidentNextVertex = (incidentEdge + 1) % incident->count;
+  clip_vertex incidentPoints[2] = {
+      {.point = incident->verticies[incidentEdge], .id = incidentEdge},
+      {.point = incident->verticies[incidentNextVertex], .id = incidentNextVertex},
+  };
+
+  // clip by side planes at both ends of reference edge
+  u32 previousEdge = (referenceEdge + referenceCount - 1) % referenceCount;
+  u32 nextEdge = (referenceEdge + 1) % referenceCount;
+  clip_vertex clipped[2];
+  clip_vertex clippedTwice[2];
+  if (ClipSegment(clipped, incidentPoints, v2_neg(tangent), -v2_dot(tangent, edgeStart),
+                  CONTACT_ID_CLIPPED(previousEdge)) < 2)
+    return 0;
+  if (ClipSegment(clippedTwice, clipped, tangent, v2_dot(tangent, edgeEnd), CONTACT_ID_CLIPPED(nextEdge)) < 2)
+    return 0;
+
+  // keep points below reference edge
+  f32 referenceOffset = v2_dot(referenceNormal, edgeStart);
+  u32 pointCount = 0;
+  for (u32 clipIndex = 0; clipIndex < ARRAY_COUNT(clippedTwice); clipIndex++) {
+    v2 incidentPoint = clippedTwice[clipIndex].point;
+    f32 separation = v2_dot(referenceNormal, incidentPoint) - referenceOffset;
+    if (separation > 0.0f)
+      continue;
+
+    // projected onto reference edge
+    v2 referencePoint = v2_sub(incidentPoint, v2_scale(referenceNormal, separation));
+
+    contact_point *point = contact->points + pointCount;
+    point->depth = -separation;
+    point->id = CONTACT_ID(referenceEdge, clippedTwice[clipIndex].id, isFlipped);
+    if (!isFlipped) {
+      // incident point belongs to B
+      point->start = incidentPoint;
+      point->end = referencePoint;
+    } else {
+      point->start = referencePoint;
+      point->end = incidentPoint;
+    }
+    pointCount++;
+  }
+
+  if (pointCount == 0)
+    return 0;
+
+  contact->normal = isFlipped ? v2_neg(referenceNormal) : referenceNormal;
+  contact->pointCount = pointCount;
+  return 1;
+}
+
+/*
+ * Fills single point contact of circle A touching point on surface of B.
+ *   normal from A to B, given in world space
+ *   depth = r - distance, distance is negative when center is inside B
+ */
+static void
+ContactCircle(contact *contact, v2 center, f32 radius, v2 surfacePoint, v2 normal, f32 distance)
+{
+  contact->normal = normal;
+  contact->pointCount = 1;
+  contact_point *point = contact->points + 0;
+  point->start = surfacePoint;
+  point->end = v2_add(center, v2_scale(normal, radius));
+  point->depth = radius - distance;
+  point->id = 0;
+}
+
+/* Contact of two overlapping circles, shared by CollisionDetect() and NarrowphaseCircles() */
+static void
+ContactCircleCircle(contact *contact, v2 positionA, f32 radiusA, v2 positionB, f32 radiusB)
+{
+  contact->normal = v2_normalize(v2_sub(positionB, positionA));
+  contact->pointCount = 1;
+  contact_point *point = contact->points + 0;
+  point->start = v2_sub(positionB, v2_scale(contact->normal, radiusB));
+  point->end = v2_add(positionA, v2_scale(contact->normal, radiusA));
+  point->depth = v2_length(v2_sub(point->end, point->start));
+  point->id = 0;
+}
+
+/*
+ * Closest point on box to circle's center, found in box's local space where
+ * box is axis aligned.
+ *   q = clamp(c, -h, h)
+ * If center is inside, nearest face pushes circle out.
+ */
+static b8
+CollisionDetectCircleBox(struct entity *circleEntity, struct entity *boxEntity, contact *contact)
+{
+  f32 radius = VolumeGetCircle(circleEntity->volume)->radius;
+  volume_box *box = VolumeGetBox(boxEntity->volume);
+  v2 halfSize = V2(box->width * 0.5f, box->height * 0.5f);
+
+  v2 center = circleEntity->position;
+  v2 localCenter = m2_mul_transpose_v2(boxEntity->rotationMatrix, v2_sub(center, boxEntity->position));
+  v2 closest = V2(Clamp(localCenter.x, -halfSize.x, halfSize.x), Clamp(localCenter.y, -halfSize.y, halfSize.y));
+
+  v2 localNormal; // outward from box
+  f32 distance;
+  b8 isInside = closest.x == localCenter.x && closest.y == localCenter.y;
+  if (isInside) {
+    f32 faceDistanceX = halfSize.x - Absolute(localCenter.x);
+    f32 faceDistanceY = halfSize.y - Absolute(localCenter.y);
+    if (faceDistanceX < faceDistanceY) {
+      localNormal = V2(localCenter.x >= 0.0f ? 1.0f : -1.0f, 0.0f);
+      closest.x = localNormal.x * halfSize.x;
+      distance = -faceDistanceX;
+    } else {
+      localNormal = V2(0.0f, localCenter.y >= 0.0f ? 1.0f : -1.0f);
+      closest.y = localNormal.y * halfSize.y;
+      distance = -faceDistanceY;
+    }
+  } else {
+    v2 delta = v2_sub(localCenter, closest);
+    f32 distanceSquare = v2_length_square(delta);
+    if (distanceSquare > Square(radius))
+      return 0;
+    distance = SquareRoot(distanceSquare);
+    localNormal = v2_scale(delta, 1.0f / distance);
+  }
+
+  v2 normal = v2_neg(m2_mul_v2(boxEntity->rotationMatrix, localNormal));
+  v2 surfacePoint = v2_add(boxEntity->position, m2_mul_v2(boxEntity->rotationMatrix, closest));
+  ContactCircle(contact, center, radius, surfacePoint, normal, distance);
+  return 1;
+}
+
+/*
+ * Finds edge of polygon with max separation from circle's center. By
+ * convexity closest feature is that edge or one of its verticies.
+ * see: Erin Catto - Box2D, b2CollidePolygonAndCircle
+ */
+static b8
+CollisionDetectCirclePolygon(struct entity *circleEntity, struct entity *polygonEntity, contact *contact)
+{
+  f32 radius = VolumeGetCircle(circleEntity->volume)->radius;
+  local_polygon polygon = VolumeGetLocalPolygon(polygonEntity->volume);
+  v2 *verticies = polygon.verticies;
+  v2 *normals = polygon.normals;
+  u32 vertexCount = polygon.count;
+
+  v2 center = circleEntity->position;
+  v2 localCenter = m2_mul_transpose_v2(polygonEntity->rotationMatrix, v2_sub(center, polygonEntity->position));
+
+  u32 edgeIndex = 0;
+  f32 separation = F32_LOWEST;
+  for (u32 index = 0; index < vertexCount; index++) {
+    f32 edgeSeparation = v2_dot(normals[index], v2_sub(localCenter, verticies[index]));
+    if (edgeSeparation > radius)
+      return 0;
+    if (edgeSeparation > separation) {
+      separation = edgeSeparation;
+      edgeIndex = index;
+    }
+  }
+
+  v2 edgeStart = verticies[edgeIndex];
+  v2 edgeEnd = verticies[(edgeIndex + 1) % vertexCount];
+  v2 edge = v2_sub(edgeEnd, edgeStart);
+
+  v2 closest;
+  v2 localNormal; // outward from polygon
+  f32 distance;
+  if (separation <= 0.0f || (v2_dot(v2_sub(localCenter, edgeStart), edge) > 0.0f &&
+                             v2_dot(v2_sub(localCenter, edgeEnd), edge) < 0.0f)) {
+    // center is inside, or in front of edge
+    localNormal = normals[edgeIndex];
+    closest = v2_sub(localCenter, v2_scale(localNormal, separation));
+    distance = separation;
+  } else {
+    // center is in region of a vertex
+    closest = v2_dot(v2_sub(localCenter, edgeStart), edge) <= 0.0f ? edgeStart : edgeEnd;
+    v2 delta = v2_sub(localCenter, closest);
+    f32 distanceSquare = v2_length_square(delta);
+    if (distanceSquare > Square(radius))
+      return 0;
+    distance = SquareRoot(distanceSquare);
+    localNormal = v2_scale(delta, 1.0f / distance);
+  }
+
+  v2 normal = v2_neg(m2_mul_v2(polygonEntity->rotationMatrix, localNormal));
+  v2 surfacePoint = v2_add(polygonEntity->position, m2_mul_v2(polygonEntity->rotationMatrix, closest));
+  ContactCircle(contact, center, radius, surfacePoint, normal, distance);
+  return 1;
+}
+
+/* Makes contact of A and B into contact of B and A */
+static void
+ContactFlip(contact *contact)
+{
+  contact->normal = v2_neg(contact->normal);
+  for (u32 pointIndex = 0; pointIndex < contact->pointCount; pointIndex++) {
+    contact_point *point = contact->points + pointIndex;
+    swap(point->start, point->end);
+  }
+}
+
+static b8
+CollisionDetect(struct entity *entityA, struct entity *entityB, pair_cache_entry *cache, contact *contact)
+{
+  // kernels below expect lower volume type as A
+  b8 isSwapped = entityA->volume->type > entityB->volume->type;
+  if (isSwapped) {
+    struct entity *tmp = entityA;
+    entityA = entityB;
+    entityB = tmp;
+  }
+
+  b8 isColliding = 0;
+  contact->pointCount = 0;
+
+  switch (entityA->volume->type | entityB->volume->type) {
+  case VOLUME_TYPE_CIRCLE | VOLUME_TYPE_CIRCLE: {
+    f32 radiusA = VolumeGetCircle(entityA->volume)->radius;
+    f32 radiusB = VolumeGetCircle(entityB->volume)->radius;
+
+    v2 distance = v2_sub(entityB->position, entityA->position);
+    isColliding = v2_length_square(distance) <= Square(radiusA + radiusB);
+    if (!isColliding)
+      return isColliding;
+
+    ContactCircleCircle(contact, entityA->position, radiusA, entityB->position, radiusB);
+  } break;
+
+  case VOLUME_TYPE_CIRCLE | VOLUME_TYPE_BOX: {
+    isColliding = CollisionDetectCircleBox(entityA, entityB, contact);
+  } break;
+
+  case VOLUME_TYPE_CIRCLE | VOLUME_TYPE_POLYGON:
+  case VOLUME_TYPE_CIRCLE | VOLUME_TYPE_TRIANGLE: {
+    isColliding = CollisionDetectCirclePolygon(entityA, entityB, contact);
+  } break;
+
+  case VOLUME_TYPE_BOX | VOLUME_TYPE_BOX:
+  case VOLUME_TYPE_POLYGON | VOLUME_TYPE_BOX:
+  case VOLUME_TYPE_POLYGON | VOLUME_TYPE_POLYGON:
+  case VOLUME_TYPE_TRIANGLE | VOLUME_TYPE_POLYGON:
+  case VOLUME_TYPE_TRIANGLE | VOLUME_TYPE_BOX:
+  case VOLUME_TYPE_TRIANGLE | VOLUME_TYPE_TRIANGLE: {
+    isColliding = CollisionDetectPolygons(entityA, entityB, cache, contact);
+  } break;
+
+  default: {
+    breakpoint("don't know how to detect collisition between volumes");
+  }; break;
+  }
+
+  if (isColliding && isSwapped)
+    ContactFlip(contact);
+
+  return isColliding;
+}
+
+/* Convex core shape of entity and radius around it, see: GJKDistance() */
+typedef struct gjk_proxy {
+  world_polygon polygon;
+  f32 radius;
+} gjk_proxy;
+
+static void
+GJKProxy(struct entity *entity, gjk_proxy *proxy)
+{
+  if (entity->volume->type == VOLUME_TYPE_CIRCLE) {
+    proxy->polygon.verticies[0] = entity->position;
+    proxy->polygon.count = 1;
+    proxy->radius = VolumeGetCircle(entity->volume)->radius;
+    return;
+  }
+
+  EntityGetPolygon(entity, &proxy->polygon);
+  proxy->radius = 0.0f;
+}
+
+static u32
+GJKProxySupportIndex(gjk_proxy *proxy, v2 direction, u32 hintIndex)
+{
+  if (proxy->polygon.count == 1)
+    return 0;
+  return WorldPolygonSupportIndex(&proxy->polygon, direction, hintIndex);
+}
+
+typedef struct gjk_vertex {
+  v2 wA;  // support point on A
+  v2 wB;  // support point on B
+  v2 w;   // wB - wA, point of Minkowski difference
+  f32 a;  // barycentric coordinate of closest point
+  u32 indexA;
+  u32 indexB;
+} gjk_vertex;
+
+typedef struct gjk_simplex {
+  gjk_vertex v[3];
+  u32 count;
+} gjk_simplex;
+
+static gjk_vertex
+GJKVertex(gjk_proxy *proxyA, u32 indexA, gjk_proxy *proxyB, u32 indexB)
+{
+  gjk_vertex vertex = {.indexA = indexA, .indexB = indexB};
+  vertex.wA = proxyA->polygon.verticies[indexA];
+  vertex.wB = proxyB->polygon.verticies[indexB];
+  vertex.w = v2_sub(vertex.wB, vertex.wA);
+  vertex.a = 1.0f;
+  return vertex;
+}
+
+/*
+ * Closest point of segment w₁w₂ to origin, in barycentric coordinates.
+ *   p = a₁w₁ + a₂w₂
+ * Regions of w₁, w₂ and the segment are tested by projecting origin on edge.
+ */
+static void
+GJKSolve2(gjk_simplex *simplex)
+{
+  v2 w1 = simplex->v[0].w;
+  v2 w2 = simplex->v[1].w;
+  v2 e12 = v2_sub(w2, w1);
+
+  // w₁ region
+  f32 d12_2 = -v2_dot(w1, e12);
+  if (d12_2 <= 0.0f) {
+    simplex->v[0].a = 1.0f;
+    simplex->count = 1;
+    return;
+  }
+
+  // w₂ region
+  f32 d12_1 = v2_dot(w2, e12);
+  if (d12_1 <= 0.0f) {
+    simplex->v[1].a = 1.0f;
+    simplex->count = 1;
+    simplex->v[0] = simplex->v[1];
+    return;
+  }
+
+  // segment region
+  f32 invD12 = 1.0f / (d12_1 + d12_2);
+  simplex->v[0].a = d12_1 * invD12;
+  simplex->v[1].a = d12_2 * invD12;
+  simplex->count = 2;
+}
+
+/*
+ * Closest point of triangle w₁w₂w₃ to origin. Verticies, then edges, then
+ * inside are tested. Triangle areas signed by n = e₁₂ × e₁₃ decide which
+ * side of edge origin is on.
+ */
+static void
+GJKSolve3(gjk_simplex *simplex)
+{
+  v2 w1 = simplex->v[0].w;
+  v2 w2 = simplex->v[1].w;
+  v2 w3 = simplex->v[2].w;
+
+  v2 e12 = v2_sub(w2, w1);
+  f32 d12_1 = v2_dot(w2, e12);
+  f32 d12_2 = -v2_dot(w1, e12);
+
+  v2 e13 = v2_sub(w3, w1);
+  f32 d13_1 = v2_dot(w3, e13);
+  f32 d13_2 = -v2_dot(w1, e13);
+
+  v2 e23 = v2_sub(w3, w2);
+  f32 d23_1 = v2_dot(w3, e23);
+  f32 d23_2 = -v2_dot(w2, e23);
+
+  f32 n123 = v2_cross(e12, e13);
+  f32 d123_1 = n123 * v2_cross(w2, w3);
+  f32 d123_2 = n123 * v2_cross(w3, w1);
+  f32 d123_3 = n123 * v2_cross(w1, w2);
+
+  // w₁ region
+  if (d12_2 <= 0.0f && d13_2 <= 0.0f) {
+    simplex->v[0].a = 1.0f;
+    simplex->count = 1;
+    return;
+  }
+
+  // e₁₂ region
+  if (d12_1 > 0.0f && d12_2 > 0.0f && d123_3 <= 0.0f) {
+    f32 invD12 = 1.0f / (d12_1 + d12_2);
+    simplex->v[0].a = d12_1 * invD12;
+    simplex->v[1].a = d12_2 * invD12;
+    simplex->count = 2;
+    return;
+  }
+
+  // e₁₃ region
+  if (d13_1 > 0.0f && d13_2 > 0.0f && d123_2 <= 0.0f) {
+    f32 invD13 = 1.0f / (d13_1 + d13_2);
+    simplex->v[0].a = d13_1 * invD13;
+    simplex->v[2].a = d13_2 * invD13;
+    simplex->count = 2;
+    simplex->v[1] = simplex->v[2];
+    return;
+  }
+
+  // w₂ region
+  if (d12_1 <= 0.0f && d23_2 <= 0.0f) {
+    simplex->v[1].a = 1.0f;
+    simplex->count = 1;
+    simplex->v[0] = simplex->v[1];
+    return;
+  }
+
+  // w₃ region
+  if (d13_1 <= 0.0f && d23_1 <= 0.0f) {
+    simplex->v[2].a = 1.0f;
+    simplex->count = 1;
+    simplex->v[0] = simplex->v[2];
+    return;
+  }
+
+  // e₂₃ region
+  if (d23_1 > 0.0f && d23_2 > 0.0f && d123_1 <= 0.0f) {
+    f32 invD23 = 1.0f / (d23_1 + d23_2);
+    simplex->v[1].a = d23_1 * invD23;
+    simplex->v[2].a = d23_2 * invD23;
+    simplex->count = 2;
+    simplex->v[0] = simplex->v[2];
+    return;
+  }
+
+  // origin is inside triangle
+  f32 invD123 = 1.0f / (d123_1 + d123_2 + d123_3);
+  simplex->v[0].a = d123_1 * invD123;
+  simplex->v[1].a = d123_2 * invD123;
+  simplex->v[2].a = d123_3 * invD123;
+  simplex->count = 3;
+}
+
+/* Direction from simplex towards origin */
+static v2
+GJKSearchDirection(gjk_simplex *simplex)
+{
+  if (simplex->count == 1)
+    return v2_neg(simplex->v[0].w);
+
+  // perpendicular of segment on origin's side
+  v2 e12 = v2_sub(simplex->v[1].w, simplex->v[0].w);
+  f32 side = v2_cross(e12, v2_neg(simplex->v[0].w));
+  return side > 0.0f ? v2_perp(e12) : v2_neg(v2_perp(e12));
+}
+
+static f32
+GJKDistance(struct entity *entityA, struct entity *entityB, gjk_simplex_cache *simplexCache, v2 *pointA, v2 *pointB)
+{
+  gjk_proxy proxyA;
+  gjk_proxy proxyB;
+  GJKProxy(entityA, &proxyA);
+  GJKProxy(entityB, &proxyB);
+
+  // warm start from cached simplex, if it still indexes valid verticies
+  gjk_simplex simplex = {};
+  if (simplexCache) {
+    for (u32 index = 0; index < simplexCache->count; index++) {
+      u32 indexA = simplexCache->indexA[index];
+      u32 indexB = simplexCache->indexB[index];
+      if (indexA >= proxyA.polygon.count || indexB >= proxyB.polygon.count) {
+        simplex.count = 0;
+        break;
+      }
+      simplex.v[simplex.count] = GJKVertex(&proxyA, indexA, &proxyB, indexB);
+      simplex.count++;
+    }
+  }
+  if (simplex.count == 0) {
+    simplex.v[0] = GJKVertex(&proxyA, 0, &proxyB, 0);
+    simplex.count = 1;
+  }
+
+  const u32 maxIterations = 20;
+  for (u32 iteration = 0; iteration < maxIterations; iteration++) {
+    // new vertex that is already in simplex means no progress
+    u32 savedCount = simplex.count;
+    u32 savedA[3];
+    u32 savedB[3];
+    for (u32 index = 0; index < savedCount; index++) {
+      savedA[index] = simplex.v[index].indexA;
+      savedB[index] = simplex.v[index].indexB;
+    }
+
+    if (simplex.count == 2)
+      GJKSolve2(&simplex);
+    else if (simplex.count == 3)
+      GJKSolve3(&simplex);
+
+    // origin is inside, shapes overlap
+    if (simplex.count == 3)
+      break;
+
+    v2 direction = GJKSearchDirection(&simplex);
+    if (v2_length_square(direction) < Square(F32_EPSILON))
+      break;
+
+    gjk_vertex *last = simplex.v + simplex.count - 1;
+    u32 indexA = GJKProxySupportIndex(&proxyA, v2_neg(direction), last->indexA);
+    u32 indexB = GJKProxySupportIndex(&proxyB, direction, last->indexB);
+
+    b8 isDuplicate = 0;
+    for (u32 index = 0; index < savedCount; index++) {
+      if (savedA[index] == indexA && savedB[index] == indexB) {
+        isDuplicate = 1;
+        break;
+      }
+    }
+    if (isDuplicate)
+      break;
+
+    simplex.v[simplex.count] = GJKVertex(&proxyA, indexA, &proxyB, indexB);
+    simplex.count++;
+  }
+
+  // closest points from barycentric coordinates
+  v2 closestA = V2(0.0f, 0.0f);
+  v2 closestB = V2(0.0f, 0.0f);
+  for (u32 index = 0; index < simplex.count; index++) {
+    gjk_vertex *vertex = simplex.v + index;
+    v2_add_ref(&closestA, v2_scale(vertex->wA, vertex->a));
+    v2_add_ref(&closestB, v2_scale(vertex->wB, vertex->a));
+  }
+  if (simplex.count == 3)
+    closestB = closestA;
+
+  if (simplexCache) {
+    simplexCache->count = simplex.count;
+    for (u32 index = 0; index < simplex.count; index++) {
+      simplexCache->indexA[index] = (u16)simplex.v[index].indexA;
+      simplexCache->indexB[index] = (u16)simplex.v[index].indexB;
+    }
+  }
+
+  // move closest points from core shapes onto surfaces
+  f32 distance = v2_length(v2_sub(closestB, closestA));
+  f32 radii = proxyA.radius + proxyB.radius;
+  if (distance > radii && distance > F32_EPSILON) {
+    v2 normal = v2_scale(v2_sub(closestB, closestA), 1.0f / distance);
+    v2_add_ref(&closestA, v2_scale(normal, proxyA.radius));
+    v2_sub_ref(&closestB, v2_scale(normal, proxyB.radius));
+    distance -= radii;
+  } else {
+    v2 midpoint = v2_scale(v2_add(closestA, closestB), 0.5f);
+    closestA = midpoint;
+    closestB = midpoint;
+    distance = 0.0f;
+  }
+
+  if (pointA)
+    *pointA = closestA;
+  if (pointB)
+    *pointB = closestB;
+  return distance;
+}
+
+/* Entity posed at fraction t of its sweep */
+static void
+EntitySweepAt(struct entity *entity, f32 t, struct entity *posed)
+{
+  *posed = *entity;
+  posed->position = v2_add(entity->sweepPosition, v2_scale(v2_sub(entity->position, entity->sweepPosition), t));
+  posed->rotation = entity->sweepRotation + (entity->rotation - entity->sweepRotation) * t;
+  EntityUpdateRotation(posed);
+}
+
+static f32
+TimeOfImpact(struct entity *entityA, struct entity *entityB, f32 target)
+{
+  v2 motionA = v2_sub(entityA->position, entityA->sweepPosition);
+  v2 motionB = v2_sub(entityB->position, entityB->sweepPosition);
+  f32 angularBound = VolumeGetBoundingRadius(entityA->volume) * Absolute(entityA->rotation - entityA->sweepRotation) +
+                     VolumeGetBoundingRadius(entityB->volume) * Absolute(entityB->rotation - entityB->sweepRotation);
+  // accept contact within quarter of target, ends iteration early
+  f32 tolerance = 0.25f * target;
+
+  gjk_simplex_cache simplex = {};
+  f32 t = 0.0f;
+  const u32 maxIterations = 20;
+  for (u32 iteration = 0; iteration < maxIterations; iteration++) {
+    struct entity posedA;
+    struct entity posedB;
+    EntitySweepAt(entityA, t, &posedA);
+    EntitySweepAt(entityB, t, &posedB);
+
+    v2 pointA, pointB;
+    f32 distance = GJKDistance(&posedA, &posedB, &simplex, &pointA, &pointB);
+    if (distance < target) {
+      // touching at start is left to discrete collision detection
+      return iteration == 0 ? 1.0f : t;
+    }
+    if (distance < target + tolerance)
+      return t;
+
+    v2 normal = v2_scale(v2_sub(pointB, pointA), 1.0f / distance);
+    f32 approach = -v2_dot(normal, v2_sub(motionB, motionA)) + angularBound;
+    if (approach <= 0.0f)
+      return 1.0f;
+
+    t += (distance - target) / approach;
+    if (t >= 1.0f)
+      return 1.0f;
+  }
+
+  // did not converge, stop at last safe time
+  return t;
+}
+
+static f32
+VolumeGetBoundingRadius(volume *volume)
+{
+  switch (volume->type) {
+  case VOLUME_TYPE_CIRCLE: {
+    volume_circle *circle = VolumeGetCircle(volume);
+    return circle->radius;
+  } break;
+
+  case VOLUME_TYPE_BOX: {
+    volume_box *box = VolumeGetBox(volume);
+    // half of diagonal
+    return 0.5f * SquareRoot(Square(box->width) + Square(box->height));
+  } break;
+
+  case VOLUME_TYPE_POLYGON: {
+    // precomputed in VolumePolygon()
+    return VolumeGetPolygon(volume)->boundingRadius;
+  } break;
+
+  case VOLUME_TYPE_TRIANGLE: {
+    // precomputed in VolumeTriangle()
+    return VolumeGetTriangle(volume)->boundingRadius;
+  } break;
+
+  default: {
+    breakpoint("unsupported volume");
+    return 0.0f;
+  } break;
+  }
+}
+
+static rect
+EntityGetBoundingRect(struct entity *entity)
+{
+  f32 radius = VolumeGetBoundingRadius(entity->volume);
+  return RectCenterHalfDim(entity->position, V2(radius, radius));
+}
+
+static void
+PairCacheInit(pair_cache *cache, memory_arena *memory, u32 pairMax)
+{
+  // load factor at most 0.5, keeps probe chains short
+  u32 capacity = 1;
+  while (capacity < pairMax * 2)
+    capacity <<= 1;
+
+  cache->capacity = capacity;
+  cache->pairMax = pairMax;
+  cache->tableIndex = 0;
+  for (u32 tableIndex = 0; tableIndex < ARRAY_COUNT(cache->tables); tableIndex++) {
+    pair_cache_entry *table = MemoryArenaPush(memory, sizeof(*table) * capacity);
+    bzero(table, sizeof(*table) * capacity);
+    cache->tables[tableIndex] = table;
+    cache->filledSlots[tableIndex] = MemoryArenaPush(memory, sizeof(*cache->filledSlots[tableIndex]) * pairMax);
+    cache->filledCounts[tableIndex] = 0;
+  }
+}
+
+static void
+PairCacheSwap(pair_cache *cache)
+{
+  cache->tableIndex ^= 1;
+
+  // table holds entries from two frames ago, empty only slots filled then
+  pair_cache_entry *table = cache->tables[cache->tableIndex];
+  u32 *filledSlots = cache->filledSlots[cache->tableIndex];
+  for (u32 filledIndex = 0; filledIndex < cache->filledCounts[cache->tableIndex]; filledIndex++)
+    table[filledSlots[filledIndex]] = (pair_cache_entry){};
+  cache->filledCounts[cache->tableIndex] = 0;
+}
+
+static u32
+PairCacheHash(u64 key)
+{
+  /* Fibonacci hashing, upper bits are well mixed
+   * see: https://probablydance.com/2018/06/16/fibonacci-hashing-the-optimization-that-the-world-forgot-or-a-better-alternative-to-integer-modulo/
+   */
+  return (u32)((key * 11400714819323198485ull) >> 32);
+}
+
+/* @return slot of key, or empty slot where key would be */
+static pair_cache_entry *
+PairCacheFind(pair_cache_entry *table, u32 capacity, u64 key)
+{
+  u32 mask = capacity - 1;
+  u32 slotIndex = PairCacheHash(key) & mask;
+  for (;;) {
+    pair_cache_entry *entry = table + slotIndex;
+    if (entry->key == key || entry->key == 0)
+      return entry;
+    slotIndex = (slotIndex + 1) & mask;
+  }
+}
+
+static pair_cache_entry *
+PairCacheInsertKey(pair_cache *cache, u64 key)
+{
+  debug_assert(key != 0);
+  pair_cache_entry *table = cache->tables[cache->tableIndex];
+  pair_cache_entry *entry = PairCacheFind(table, cache->capacity, key);
+  if (entry->key == key)
+    return entry;
+
+  // full cache is expected in dense piles, caller solves pair without warm starting
+  u32 *filledCount = cache->filledCounts + cache->tableIndex;
+  if (*filledCount == cache->pairMax)
+    return 0;
+  cache->filledSlots[cache->tableIndex][*filledCount] = (u32)(entry - table);
+  *filledCount += 1;
+
+  pair_cache_entry *previous = PairCacheFind(cache->tables[cache->tableIndex ^ 1], cache->capacity, key);
+  if (previous->key == key)
+    *entry = *previous;
+  else
+    entry->key = key;
+
+  return entry;
+}
+
+static pair_cache_entry *
+PairCacheInsert(pair_cache *cache, u32 entityAIndex, u32 entityBIndex)
+{
+  debug_assert(entityAIndex < entityBIndex);
+  // null entity has index 0, so key is never 0
+  u64 key = (u64)entityAIndex << 32 | (u64)entityBIndex;
+  return PairCacheInsertKey(cache, key);
+}
+
+static pair_cache_entry *
+PairCacheInsertTerrain(pair_cache *cache, u32 triangleIndex, u32 entityIndex)
+{
+  // top bit keeps terrain keys apart from entity pair keys
+  debug_assert(triangleIndex < ((u32)1 << 31));
+  u64 key = (u64)1 << 63 | (u64)triangleIndex << 32 | (u64)entityIndex;
+  return PairCacheInsertKey(cache, key);
+}
+
+static void
+PairRuleTableInit(pair_rule_table *table, memory_arena *memory, u32 ruleMax)
+{
+  // load factor at most 0.5, keeps probe chains short
+  u32 capacity = 1;
+  while (capacity < ruleMax * 2)
+    capacity <<= 1;
+
+  table->capacity = capacity;
+  table->count = 0;
+  table->rules = MemoryArenaPush(memory, sizeof(*table->rules) * capacity);
+  bzero(table->rules, sizeof(*table->rules) * capacity);
+}
+
+static u64
+PairRuleKey(u32 entityAIndex, u32 entityBIndex)
+{
+  debug_assert(entityAIndex != entityBIndex);
+  // null entity has index 0, so key is never 0
+  return (u64)Minimum(entityAIndex, entityBIndex) << 32 | (u64)Maximum(entityAIndex, entityBIndex);
+}
+
+/* @return slot of key, or empty slot where key would be */
+static pair_rule *
+PairRuleFind(pair_rule_table *table, u64 key)
+{
+  u32 mask = table->capacity - 1;
+  u32 slotIndex = PairCacheHash(key) & mask;
+  for (;;) {
+    pair_rule *rule = table->rules + slotIndex;
+    if (rule->key == key || rule->key == 0)
+      return rule;
+    slotIndex = (slotIndex + 1) & mask;
+  }
+}
+
+static pair_rule *
+PairRuleSet(pair_rule_table *table, u32 entityAIndex, u32 entityBIndex)
+{
+  u64 key = PairRuleKey(entityAIndex, entityBIndex);
+  pair_rule *rule = PairRuleFind(table, key);
+  if (rule->key == key)
+    return rule;
+
+  // keep at least one slot empty, so lookups terminate
+  if (table->count + 1 >= table->capacity)
+    return 0;
+
+  *rule = (pair_rule){.key = key};
+  table->count++;
+  return rule;
+}
+
+static pair_rule *
+PairRuleGet(pair_rule_table *table, u32 entityAIndex, u32 entityBIndex)
+{
+  if (table->count == 0)
+    return 0;
+
+  pair_rule *rule = PairRuleFind(table, PairRuleKey(entityAIndex, entityBIndex));
+  return rule->key ? rule : 0;
+}
+
+/*
+ * Empties slot and shifts following entries of probe chain back into it,
+ * unless that would move entry before its home slot.
+ * see: https://en.wikipedia.org/wiki/Linear_probing#Deletion
+ */
+static void
+PairRuleRemoveAt(pair_rule_table *table, u32 emptyIndex)
+{
+  u32 mask = table->capacity - 1;
+  u32 slotIndex = emptyIndex;
+  for (;;) {
+    table->rules[emptyIndex].key = 0;
+
+    for (;;) {
+      slotIndex = (slotIndex + 1) & mask;
+      pair_rule *rule = table->rules + slotIndex;
+      if (rule->key == 0) {
+        table->count--;
+        return;
+      }
+
+      // entry can move back only if its home is not between empty and its slot
+      u32 homeIndex = PairCacheHash(rule->key) & mask;
+      u32 distanceFromHome = (slotIndex - homeIndex) & mask;
+      u32 distanceFromEmpty = (slotIndex - emptyIndex) & mask;
+      if (distanceFromHome >= distanceFromEmpty)
+        break;
+    }
+
+    table->rules[emptyIndex] = table->rules[slotIndex];
+    emptyIndex = slotIndex;
+  }
+}
+
+static b8
+PairRuleRemove(pair_rule_table *table, u32 entityAIndex, u32 entityBIndex)
+{
+  pair_rule *rule = PairRuleFind(table, PairRuleKey(entityAIndex, entityBIndex));
+  if (rule->key == 0)
+    return 0;
+
+  PairRuleRemoveAt(table, (u32)(rule - table->rules));
+  return 1;
+}
+
+static u32
+PairRuleRemoveEntity(pair_rule_table *table, u32 entityIndex)
+{
+  u32 removedCount = 0;
+  for (u32 slotIndex = 0; slotIndex < table->capacity && table->count > 0; slotIndex++) {
+    // removal shifts next entry into this slot, check it again
+    for (;;) {
+      u64 key = table->rules[slotIndex].key;
+      if (key == 0 || ((u32)(key >> 32) != entityIndex && (u32)key != entityIndex))
+        break;
+
+      PairRuleRemoveAt(table, slotIndex);
+      removedCount++;
+    }
+  }
+
+  return removedCount;
+}
+
+static collision_pair *
+BroadphaseSweepAndPrune(memory_arena *memory, struct entity *entities, u32 entityCount, pair_rule_table *rules,
+                        u32 *pairCount)
+{
+  *pairCount = 0;
+  if (entityCount <= 2)
+    return 0;
+
+  u32 count = entityCount - 1;
+  rect *bounds = MemoryArenaPush(memory, sizeof(*bounds) * entityCount);
+  u32 *order = MemoryArenaPush(memory, sizeof(*order) * count);
+  // worst case every entity overlaps with every other
+  u32 pairMax = count * (count - 1) / 2;
+  collision_pair *pairs = MemoryArenaPush(memory, sizeof(*pairs) * pairMax);
+
+  for (u32 entityIndex = 1; entityIndex < entityCount; entityIndex++) {
+    bounds[entityIndex] = EntityGetBoundingRect(entities + entityIndex);
+    order[entityIndex - 1] = entityIndex;
+  }
+
+  // sort by left edge. insertion sort is stable, keeps pair order deterministic.
+  for (u32 index = 1; index < count; index++) {
+    u32 entityIndex = order[index];
+    f32 minX = bounds[entityIndex].min.x;
+    u32 insertIndex = index;
+    while (insertIndex > 0 && bounds[order[insertIndex - 1]].min.x > minX) {
+      order[insertIndex] = order[insertIndex - 1];
+      insertIndex--;
     }
+    order[insertIndex] = entityIndex;
+  }
 
-    /*
-     * Entities collided.
-     * Find penetration depth using Expanding Polytope Algorithm (EPA)
-     * see: https://winter.dev/articles/epa-algorithm
-     */
-
-    struct v2 polytope[16];
-    u8 vertexCount = ARRAY_COUNT(points);
-    memcpy(polytope, points, sizeof(*points) * vertexCount);
-
-    struct edge {
-      u8 index;
-      f32 distance;
-      v2 normal;
-    } closestEdge;
-
-    while (vertexCount < ARRAY_COUNT(polytope)) {
-      closestEdge.distance = F32_MAX;
-
-      // find the edge closest to the origin
-      for (u8 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
-        u8 Aindex = vertexIndex;
-        u8 Bindex = (u8)((vertexIndex + 1) % vertexCount);
-        v2 A = polytope[Aindex];
-        v2 B = polytope[Bindex];
-        v2 AB = v2_sub(B, A);
-        v2 normal = v2_normalize(v2_perp(AB));
-        debug_assert(v2_length_square(normal) != 0);
-        f32 distance = v2_dot(A, normal);
-        if (distance < 0) {
-          distance *= -1.0f;
-          v2_neg_ref(&normal);
-        }
+  // sweep, only entities that start before this one ends can overlap
+  u32 pairIndex = 0;
+  for (u32 index = 0; index < count; index++) {
+    u32 entityAIndex = order[index];
+    rect boundA = bounds[entityAIndex];
+    for (u32 otherIndex = index + 1; otherIndex < count; otherIndex++) {
+      u32 entityBIndex = order[otherIndex];
+      rect boundB = bounds[entityBIndex];
+      if (boundB.min.x > boundA.max.x)
+        break;
 
-        if (distance < closestEdge.distance) {
-          closestEdge.distance = distance;
-          closestEdge.normal = normal;
-          closestEdge.index = Bindex;
-        }
-      }
+      if (!IsEntityAwake(entities + entityAIndex) && !IsEntityAwake(entities + entityBIndex))
+        continue;
+
+      if (!ShouldEntitiesCollide(entities + entityAIndex, entities + entityBIndex))
+        continue;
 
-      // test if there is point further out in normal's direction
-      support = Support(entityA, entityB, closestEdge.normal);
-      f32 supportDistance = v2_dot(support, closestEdge.normal);
+      if (!IsAABBOverlapping(boundA, boundB))
+        continue;
 
-      f32 epsilon = 0.0001f;
-      if (Absolute(supportDistance - closestEdge.distance) <= epsilon) {
-        break;
-      }
-      /* expand polytope, insert support to polytope
-       * CASE 1:
-       *   1 2 3 4
-       * 0
-       * ---------
-       * 0 1 2 3 4
-       *
-       * CASE 2:
-       * 0   2 3 4
-       *   1
-       * ---------
-       * 0 1 2 3 4
+      pair_rule *rule = rules ? PairRuleGet(rules, entityAIndex, entityBIndex) : 0;
+      if (rule && (rule->flags & PAIR_RULE_IGNORE))
+        continue;
+
+      debug_assert(pairIndex < pairMax);
+      collision_pair *pair = pairs + pairIndex;
+      pair->entityAIndex = Minimum(entityAIndex, entityBIndex);
+      pair->entityBIndex = Maximum(entityAIndex, entityBIndex);
+      pair->cache = 0;
+      pair->rule = rule;
+      pairIndex++;
+    }
+  }
+
+  *pairCount = pairIndex;
+  return pairs;
+}
+
+static u32
+Narrowphase(struct entity *entities, collision_pair *pairs, u32 startIndex, u32 endIndex, collision *collisions)
+{
+  u32 collisionCount = 0;
+  for (u32 pairIndex = startIndex; pairIndex < endIndex; pairIndex++) {
+    collision_pair *pair = pairs + pairIndex;
+    struct entity *entityA = entities + pair->entityAIndex;
+    struct entity *entityB = entities + pair->entityBIndex;
+
+    pair_cache_entry *cache = pair->cache;
+    if (cache && cache->distance > 0.0f) {
+      /* Point of entity moves at most by
+       *   |∆p| + r |∆θ|
+       * where r is bounding radius. Pair stays apart until sum of both
+       * reaches distance.
        */
-      u8 before = closestEdge.index;
-      u8 after = vertexCount - before;
-      memcpy(polytope + (before + 1), polytope + before, sizeof(*polytope) * after);
-      polytope[before] = support;
-      vertexCount++;
-    }
-
-    // BUG: TODO: Entity partially stucks at corner after colliding.
-    //            Is Minkowski Difference correct?
-
-    // TODO: Is contact information correct?
-    // see:
-    //   - "Dirk Gregorius - Robust Contact Creation for Physics Simulation"
-    //     https://gdcvault.com/play/1022193/Physics-for-Game-Programmers-Robust
-    //     https://cdn-a.blazestreaming.com/out/v1/a914e787bbfd48af89b2fdc4721cb75c/38549d9a185b445888c6fbc2e2e792e9/50413c5b8a95441e919f0a1579606e47/index.m3u8
-    contact->normal = closestEdge.normal;
-    contact->depth = closestEdge.distance;
-    contact->start = FindFurthestPoint(entityB, v2_neg(contact->normal));
-    contact->end = FindFurthestPoint(entityA, contact->normal);
-#else
-    /* From paper:
-     *   2024 - Wei Gao - Efficient Incremental Penetration Depth Estimation between Convex Geometries
-     * Reference implementation:
-     *   https://github.com/weigao95/mind-fcl/blob/86edd6c89db0682cc9f99ae852117c8992ad966a/include/fcl/cvx_collide/mpr.hpp#L501
-     *   See below for how it used in test
-     *   https://github.com/weigao95/mind-fcl/blob/86edd6c89db0682cc9f99ae852117c8992ad966a/test/cvx_collide/test_mpr_penetration.cpp#L65
-     */
-    u32 maxIterations = 1000;
-    f32 tolerance = 1e-6f;
-
-    v3 d = {.xy = v2_normalize(entityB->velocity)};
-    if (v3_length_square(d) == 0.0f) {
-      d = (v3){.xy = v2_normalize(v2_sub(entityB->position, entityA->position))};
-    }
-    debug_assert(v3_length_square(d) != 0);
-
-    // v0_to_O is the direction. This v0 is actually mock.
-    // It may NOT lie in the MinkowskiDiff shape
-    v3 v0 = v3_neg(d);
-
-    v3 v1_direction = v3_normalize(d);
-    v3 v1 = {.xy = Support(entityA, entityB, v1_direction.xy)};
-
-    // no intersect case 1
-    if (v3_dot(v1_direction, v1) < 0) {
-      return 0;
+      f32 motion = v2_length(v2_sub(entityA->position, cache->positionA)) +
+                   v2_length(v2_sub(entityB->position, cache->positionB)) +
+                   VolumeGetBoundingRadius(entityA->volume) * Absolute(entityA->rotation - cache->rotationA) +
+                   VolumeGetBoundingRadius(entityB->volume) * Absolute(entityB->rotation - cache->rotationB);
+      if (motion < cache->distance)
+        continue;
     }
 
-    v3 v2_direction = v3_cross(v0, v1);
-    // LEFTOFF: v2_direction is 0? Is it implementation issue?
-    debug_assert(v3_length_square(v2_direction) != 0);
-    // o_to_v0 and o_to_v1 can be co-linear, check it
-    // Note that v0 MUST have norm one
-    // This equation might be written as
-    //   cross(o_to_v0.normalized(), o_to_v1.normalized()).norm() <= tolerance
-    // which can be further expanded as
-    //   cross(o_to_v0, o_to_v1).norm() <= tolerance * v0.norm() * v1.norm()
-    // However, we do not want to compute the L2 norm, thus replace it with
-    // abs norm, which is much easier to compute.
-    if (v3_absolute_norm(v2_direction) <= v3_absolute_norm(v1) * tolerance) {
-      // o_to_v0 and o_to_v1 can be co-linear, from the condition above
-      // v1_direction.dot(v1) = - v0_interior.dot(v1) < 0 is False
-      // which implies
-      // - v0_interior.dot(v1) > 0  --> v0_interior.dot(v1) < 0
-      // As v0 = o_to_v0, v1 = o_to_v1, we have
-      // o_to_v0.dot(o_to_v1) < 0, o is in the middle of v0/v1
-      // As v0 is an interior point, v1 is a boundary point
-      // We conclude O must be within the shape
-      contact->depth = v3_dot(v1, d);
-      contact->normal = v3_normalize(v1_direction).xy;
-      contact->start = FindFurthestPoint(entityB, v2_neg(contact->normal));
-      contact->end = FindFurthestPoint(entityA, contact->normal);
-      return 1;
-    }
-
-    v3 v2 = {.xy = Support(entityA, entityB, v3_normalize(v2_direction).xy)};
-
-    // no intersect
-    if (v3_dot(v2_direction, v2) < 0)
-      return 0;
+    contact contact = {};
+    if (!CollisionDetect(entityA, entityB, cache, &contact)) {
+      if (cache) {
+        cache->distance = GJKDistance(entityA, entityB, &cache->simplex, 0, 0);
+        cache->positionA = entityA->position;
+        cache->positionB = entityB->position;
+        cache->rotationA = entityA->rotation;
+        cache->rotationB = entityB->rotation;
+      }
+      continue;
+    }
+
+    if (cache)
+      cache->distance = 0.0f;
+
+    collision *collision = collisions + collisionCount;
+    collision->pairIndex = pairIndex;
+    collision->entityAIndex = pair->entityAIndex;
+    collision->entityBIndex = pair->entityBIndex;
+    collision->cache = cache;
+    collision->rule = pair->rule;
+    collision->contact = contact;
+    collisionCount++;
+  }
+
+  return collisionCount;
+}
+
+static circle_pack
+CirclePack(memory_arena *memory, struct entity *entities, u32 entityCount)
+{
+  circle_pack pack = {
+      .xs = MemoryArenaPush(memory, sizeof(*pack.xs) * entityCount),
+      .ys = MemoryArenaPush(memory, sizeof(*pack.ys) * entityCount),
+      .radii = MemoryArenaPush(memory, sizeof(*pack.radii) * entityCount),
+  };
+
+  for (u32 entityIndex = 0; entityIndex < entityCount; entityIndex++) {
+    struct entity *entity = entities + entityIndex;
+    pack.xs[entityIndex] = entity->position.x;
+    pack.ys[entityIndex] = entity->position.y;
+    pack.radii[entityIndex] = 0.0f;
+    // null entity has no volume
+    if (entity->volume && entity->volume->type == VOLUME_TYPE_CIRCLE)
+      pack.radii[entityIndex] = VolumeGetCircle(entity->volume)->radius;
+  }
+
+  return pack;
+}
 
-    // it is better to form portal faces to be oriented "outside" origin
-    // Here O must be an interior point in penetration query
-    v3 v3_direction = v3_cross(v1, v2);
-    if (v3_dot(v3_direction, v0) > 0) {
-      swap(v1, v2);
-      swap(v1_direction, v2_direction);
-      v3_neg_ref(&v3_direction);
+static u32
+BroadphaseBucketPairs(memory_arena *memory, struct entity *entities, collision_pair *pairs, u32 pairCount)
+{
+  memory_temp tempMemory = MemoryTempBegin(memory);
+  collision_pair *others = MemoryArenaPush(tempMemory.arena, sizeof(*others) * pairCount);
+
+  u32 circlePairCount = 0;
+  u32 otherCount = 0;
+  for (u32 pairIndex = 0; pairIndex < pairCount; pairIndex++) {
+    collision_pair *pair = pairs + pairIndex;
+    b8 isCircleCircle = entities[pair->entityAIndex].volume->type == VOLUME_TYPE_CIRCLE &&
+                        entities[pair->entityBIndex].volume->type == VOLUME_TYPE_CIRCLE;
+    // circle pairs are written behind read index, never overwrite unread pairs
+    if (isCircleCircle) {
+      pairs[circlePairCount] = *pair;
+      circlePairCount++;
+    } else {
+      others[otherCount] = *pair;
+      otherCount++;
     }
+  }
+  memcpy(pairs + circlePairCount, others, sizeof(*others) * otherCount);
 
-    v3 v3 = {.xy = Support(entityA, entityB, v3_normalize(v3_direction).xy)};
+  MemoryTempEnd(&tempMemory);
+  return circlePairCount;
+}
 
-    // no intersect
-    if (v3_dot(v3_direction, v3) < 0) {
-      return 0;
+static void
+NarrowphaseCircleHit(circle_pack *circles, collision_pair *pairs, u32 pairIndex, collision *collision)
+{
+  collision_pair *pair = pairs + pairIndex;
+  u32 a = pair->entityAIndex;
+  u32 b = pair->entityBIndex;
+  collision->pairIndex = pairIndex;
+  collision->entityAIndex = a;
+  collision->entityBIndex = b;
+  collision->cache = pair->cache;
+  collision->rule = pair->rule;
+  collision->contact = (contact){};
+  ContactCircleCircle(&collision->contact, V2(circles->xs[a], circles->ys[a]), circles->radii[a],
+                      V2(circles->xs[b], circles->ys[b]), circles->radii[b]);
+}
+
+static u32
+NarrowphaseCircles(circle_pack *circles, collision_pair *pairs, u32 startIndex, u32 endIndex, collision *collisions)
+{
+  u32 collisionCount = 0;
+  u32 pairIndex = startIndex;
+
+#if defined(__AVX2__)
+  /* Same test as CollisionDetect(), 8 pairs at once.
+   *   |p_B - p_A|² <= (r_A + r_B)²
+   * Lanes that hit are rare, contacts are built for them only.
+   */
+  const u32 width = 8;
+  for (; pairIndex + width <= endIndex; pairIndex += width) {
+    u32 indicesA[8];
+    u32 indicesB[8];
+    for (u32 lane = 0; lane < width; lane++) {
+      indicesA[lane] = pairs[pairIndex + lane].entityAIndex;
+      indicesB[lane] = pairs[pairIndex + lane].entityBIndex;
+    }
+    __m256i a = _mm256_loadu_si256((__m256i *)indicesA);
+    __m256i b = _mm256_loadu_si256((__m256i *)indicesB);
+
+    __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(circles->xs, b, 4), _mm256_i32gather_ps(circles->xs, a, 4));
+    __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(circles->ys, b, 4), _mm256_i32gather_ps(circles->ys, a, 4));
+    __m256 radii =
+        _mm256_add_ps(_mm256_i32gather_ps(circles->radii, a, 4), _mm256_i32gather_ps(circles->radii, b, 4));
+    __m256 distanceSquare = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+    __m256 isColliding = _mm256_cmp_ps(distanceSquare, _mm256_mul_ps(radii, radii), _CMP_LE_OQ);
+
+    // lowest lane first keeps collisions in pair order
+    u32 hitMask = (u32)_mm256_movemask_ps(isColliding);
+    while (hitMask) {
+      u32 lane = (u32)__builtin_ctz(hitMask);
+      hitMask &= hitMask - 1;
+      NarrowphaseCircleHit(circles, pairs, pairIndex + lane, collisions + collisionCount);
+      collisionCount++;
     }
+  }
+#endif
 
-    // Scale the v0 to the max of v1/v2/v3
-    struct v3 v0_scaled = v0;
-    {
-      f32 squaredNorms[3] = {v3_length_square(v1), v3_length_square(v2), v3_length_square(v3)};
-      f32 max = squaredNorms[0];
-      for (u32 index = 1; index < ARRAY_COUNT(squaredNorms); index++) {
-        f32 squaredNorm = squaredNorms[index];
-        if (squaredNorm > max)
-          max = squaredNorm;
-      }
-      v3_scale_ref(&v0_scaled, SquareRoot(max));
+  for (; pairIndex < endIndex; pairIndex++) {
+    collision_pair *pair = pairs + pairIndex;
+    u32 a = pair->entityAIndex;
+    u32 b = pair->entityBIndex;
+    f32 dx = circles->xs[b] - circles->xs[a];
+    f32 dy = circles->ys[b] - circles->ys[a];
+    f32 radii = circles->radii[a] + circles->radii[b];
+    if (dx * dx + dy * dy > radii * radii)
+      continue;
+
+    NarrowphaseCircleHit(circles, pairs, pairIndex, collisions + collisionCount);
+    collisionCount++;
+  }
+
+  return collisionCount;
+}
+
+/* Cell that contains point, clamped to grid */
+static void
+TerrainGetCell(terrain *terrain, v2 point, u32 *cellX, u32 *cellY)
+{
+  v2 local = v2_scale(v2_sub(point, terrain->origin), 1.0f / terrain->cellSize);
+  // grid may be one cell wide, Clamp() needs min below max.
+  // truncation is floor for values that are not negative.
+  *cellX = (u32)Minimum(Maximum(local.x, 0.0f), (f32)(terrain->cellCountX - 1));
+  *cellY = (u32)Minimum(Maximum(local.y, 0.0f), (f32)(terrain->cellCountY - 1));
+}
+
+static void
+TerrainInit(terrain *terrain, memory_arena *memory, u32 triangleCount, v2 verticies[static triangleCount * 3],
+            f32 cellSize)
+{
+  debug_assert(cellSize > 0.0f);
+  *terrain = (struct terrain){
+      .triangles = MemoryArenaPush(memory, sizeof(*terrain->triangles) * triangleCount),
+      .positions = MemoryArenaPush(memory, sizeof(*terrain->positions) * triangleCount),
+      .bounds = MemoryArenaPush(memory, sizeof(*terrain->bounds) * triangleCount),
+      .filter = COLLISION_FILTER_DEFAULT,
+      .cellSize = cellSize,
+  };
+
+  rect terrainBound = {.min = {F32_MAX, F32_MAX}, .max = {F32_LOWEST, F32_LOWEST}};
+  for (u32 triangleIndex = 0; triangleIndex < triangleCount; triangleIndex++) {
+    v2 *triangleVerticies = verticies + triangleIndex * 3;
+    volume *triangle = VolumeTriangle(memory, triangleVerticies[0], triangleVerticies[1], triangleVerticies[2]);
+    if (!triangle)
+      continue;
+
+    rect bound = {.min = triangleVerticies[0], .max = triangleVerticies[0]};
+    for (u32 vertexIndex = 1; vertexIndex < 3; vertexIndex++) {
+      v2 vertex = triangleVerticies[vertexIndex];
+      bound.min = V2(Minimum(bound.min.x, vertex.x), Minimum(bound.min.y, vertex.y));
+      bound.max = V2(Maximum(bound.max.x, vertex.x), Maximum(bound.max.y, vertex.y));
     }
+    terrainBound.min = V2(Minimum(terrainBound.min.x, bound.min.x), Minimum(terrainBound.min.y, bound.min.y));
+    terrainBound.max = V2(Maximum(terrainBound.max.x, bound.max.x), Maximum(terrainBound.max.y, bound.max.y));
+
+    u32 index = terrain->triangleCount;
+    terrain->triangles[index] = triangle;
+    terrain->positions[index] = VolumeGetTriangle(triangle)->centroid;
+    terrain->bounds[index] = bound;
+    terrain->triangleCount++;
+  }
 
-    // The loop to find the portal
-    struct v3 o_to_v0 = v0;
-    f32 v0_absoluteNorm = v3_absolute_norm(v0);
-    for (u32 findCandidatePortalIteration = 0;; findCandidatePortalIteration++) {
-      if (findCandidatePortalIteration == maxIterations) {
-        // Iteration limit
-        return 0;
+  if (terrain->triangleCount == 0)
+    return;
+
+  v2 dim = RectGetDim(terrainBound);
+  terrain->origin = terrainBound.min;
+  terrain->cellCountX = (u32)(dim.x / cellSize) + 1;
+  terrain->cellCountY = (u32)(dim.y / cellSize) + 1;
+  u32 cellCount = terrain->cellCountX * terrain->cellCountY;
+  terrain->cellOffsets = MemoryArenaPush(memory, sizeof(*terrain->cellOffsets) * (cellCount + 1));
+  bzero(terrain->cellOffsets, sizeof(*terrain->cellOffsets) * (cellCount + 1));
+
+  // count triangles of each cell
+  u32 entryCount = 0;
+  for (u32 triangleIndex = 0; triangleIndex < terrain->triangleCount; triangleIndex++) {
+    u32 minX, minY, maxX, maxY;
+    TerrainGetCell(terrain, terrain->bounds[triangleIndex].min, &minX, &minY);
+    TerrainGetCell(terrain, terrain->bounds[triangleIndex].max, &maxX, &maxY);
+    for (u32 cellY = minY; cellY <= maxY; cellY++) {
+      for (u32 cellX = minX; cellX <= maxX; cellX++) {
+        terrain->cellOffsets[cellY * terrain->cellCountX + cellX]++;
+        entryCount++;
       }
+    }
+  }
 
-      struct v3 v0_to_v1 = v3_sub(v1, v0);
-      struct v3 v0_to_v2 = v3_sub(v2, v0);
-      struct v3 v0_to_v3 = v3_sub(v3, v0);
-
-      // Update the corresponded vertex
-      // These normal are not oriented
-      struct v3 v031_normal = v3_cross(v0_to_v3, v0_to_v1);
-      struct v3 v012_normal = v3_cross(v0_to_v1, v0_to_v2);
-      // Orient it
-      if (v3_dot(v0_to_v2, v031_normal) < 0) {
-        swap(v2, v3);
-        swap(v2_direction, v3_direction);
-        swap(v0_to_v2, v0_to_v3);
-
-        // Something tricky here, note the changing of vectors
-        swap(v012_normal, v031_normal);
-        v3_neg_ref(&v031_normal);
-        v3_neg_ref(&v012_normal);
+  // offset is end of cell, filling backwards moves it to start of cell
+  for (u32 cellIndex = 1; cellIndex <= cellCount; cellIndex++)
+    terrain->cellOffsets[cellIndex] += terrain->cellOffsets[cellIndex - 1];
+
+  // backwards, so triangles of cell stay in increasing order
+  terrain->cellTriangles = MemoryArenaPush(memory, sizeof(*terrain->cellTriangles) * entryCount);
+  for (u32 triangleIndex = terrain->triangleCount; triangleIndex-- > 0;) {
+    u32 minX, minY, maxX, maxY;
+    TerrainGetCell(terrain, terrain->bounds[triangleIndex].min, &minX, &minY);
+    TerrainGetCell(terrain, terrain->bounds[triangleIndex].max, &maxX, &maxY);
+    for (u32 cellY = minY; cellY <= maxY; cellY++) {
+      for (u32 cellX = minX; cellX <= maxX; cellX++) {
+        u32 *offset = terrain->cellOffsets + cellY * terrain->cellCountX + cellX;
+        (*offset)--;
+        terrain->cellTriangles[*offset] = triangleIndex;
       }
+    }
+  }
+  debug_assert(terrain->cellOffsets[0] == 0 && terrain->cellOffsets[cellCount] == entryCount);
+}
+
+/*
+ * Does bound overlap triangle, and is cell the one that reports it. Both
+ * bounds cover cell of overlap's left bottom corner, only that cell reports
+ * pair, so triangles spanning many cells are found once.
+ */
+static b8
+TerrainIsPairCell(terrain *terrain, rect bound, u32 triangleIndex, u32 cellX, u32 cellY)
+{
+  rect triangleBound = terrain->bounds[triangleIndex];
+  if (!IsAABBOverlapping(bound, triangleBound))
+    return 0;
+
+  v2 overlapMin = V2(Maximum(bound.min.x, triangleBound.min.x), Maximum(bound.min.y, triangleBound.min.y));
+  u32 overlapX, overlapY;
+  TerrainGetCell(terrain, overlapMin, &overlapX, &overlapY);
+  return overlapX == cellX && overlapY == cellY;
+}
 
-      debug_assert(v3_dot(v0_to_v2, v031_normal) >= 0);
-      b8 is_v031_seperated_v2_and_o =
-          v3_dot(o_to_v0, v031_normal) > F32_EPSILON * v0_absoluteNorm * v3_absolute_norm(v031_normal);
-      if (is_v031_seperated_v2_and_o) {
-        // Orient the normal towards O
-        debug_assert(v3_dot(o_to_v0, v012_normal) > 0);
-        struct v3 search_v3_direction = v012_normal;
-        v3_neg_ref(&search_v3_direction);
-
-        // Find a new v3 in that direction
-        v3 = (struct v3){.xy = Support(entityA, entityB, search_v3_direction.xy)};
-        v3_direction = search_v3_direction;
-
-        // Miss detection
-        if (v3_dot(v3, search_v3_direction) < 0) {
-          // detect seperated
-          return 0;
+/*
+ * Triangles whose bounds overlap bounds of entity.
+ * @param pairs receives pairs, may be 0 to only count them
+ * @return number of pairs
+ */
+static u32
+TerrainFindPairs(terrain *terrain, struct entity *entity, u32 entityIndex, terrain_pair *pairs)
+{
+  rect bound = EntityGetBoundingRect(entity);
+  u32 minX, minY, maxX, maxY;
+  TerrainGetCell(terrain, bound.min, &minX, &minY);
+  TerrainGetCell(terrain, bound.max, &maxX, &maxY);
+
+  u32 pairCount = 0;
+  for (u32 cellY = minY; cellY <= maxY; cellY++) {
+    for (u32 cellX = minX; cellX <= maxX; cellX++) {
+      u32 cellIndex = cellY * terrain->cellCountX + cellX;
+      for (u32 offset = terrain->cellOffsets[cellIndex]; offset < terrain->cellOffsets[cellIndex + 1]; offset++) {
+        u32 triangleIndex = terrain->cellTriangles[offset];
+        if (!TerrainIsPairCell(terrain, bound, triangleIndex, cellX, cellY))
+          continue;
+
+        if (pairs) {
+          terrain_pair *pair = pairs + pairCount;
+          pair->triangleIndex = triangleIndex;
+          pair->entityIndex = entityIndex;
+          pair->cache = 0;
         }
+        pairCount++;
+      }
+    }
+  }
+
+  return pairCount;
+}
+
+static terrain_pair *
+TerrainBroadphase(memory_arena *memory, terrain *terrain, struct entity *entities, u32 entityCount,
+                  u32 *pairCount)
+{
+  *pairCount = 0;
+  if (terrain->triangleCount == 0)
+    return 0;
+
+  // terrain against entity filters, see: TerrainGetBody()
+  struct entity body = {.filter = terrain->filter};
+
+  // counted first, so exactly as many pairs as found are allocated
+  u32 count = 0;
+  for (u32 entityIndex = 1; entityIndex < entityCount; entityIndex++) {
+    struct entity *entity = entities + entityIndex;
+    if (!IsEntityAwake(entity) || !ShouldEntitiesCollide(&body, entity))
+      continue;
+    count += TerrainFindPairs(terrain, entity, entityIndex, 0);
+  }
+
+  terrain_pair *pairs = MemoryArenaPush(memory, sizeof(*pairs) * count);
+  u32 pairIndex = 0;
+  for (u32 entityIndex = 1; entityIndex < entityCount; entityIndex++) {
+    struct entity *entity = entities + entityIndex;
+    if (!IsEntityAwake(entity) || !ShouldEntitiesCollide(&body, entity))
+      continue;
+    pairIndex += TerrainFindPairs(terrain, entity, entityIndex, pairs + pairIndex);
+  }
+  debug_assert(pairIndex == count);
+
+  *pairCount = count;
+  return pairs;
+}
+
+/* Triangle of terrain as static entity, so collision routines of entities apply to it */
+static void
+TerrainGetBody(terrain *terrain, u32 triangleIndex, struct entity *body)
+{
+  *body = (struct entity){
+      .position = terrain->positions[triangleIndex],
+      .rotationMatrix = {.x = {1.0f, 0.0f}, .y = {0.0f, 1.0f}},
+      .filter = terrain->filter,
+      .volume = terrain->triangles[triangleIndex],
+  };
+}
 
-        // Loop again
+static u32
+TerrainNarrowphase(terrain *terrain, struct entity *entities, terrain_pair *pairs, u32 startIndex, u32 endIndex,
+                   collision *collisions)
+{
+  u32 collisionCount = 0;
+  for (u32 pairIndex = startIndex; pairIndex < endIndex; pairIndex++) {
+    terrain_pair *pair = pairs + pairIndex;
+    struct entity *entity = entities + pair->entityIndex;
+    struct entity body;
+    TerrainGetBody(terrain, pair->triangleIndex, &body);
+
+    pair_cache_entry *cache = pair->cache;
+    if (cache && cache->distance > 0.0f) {
+      // terrain does not move, only entity closes distance. see: Narrowphase()
+      f32 motion = v2_length(v2_sub(entity->position, cache->positionB)) +
+                   VolumeGetBoundingRadius(entity->volume) * Absolute(entity->rotation - cache->rotationB);
+      if (motion < cache->distance)
         continue;
+    }
+
+    contact contact = {};
+    if (!CollisionDetect(&body, entity, cache, &contact)) {
+      if (cache) {
+        cache->distance = GJKDistance(&body, entity, &cache->simplex, 0, 0);
+        cache->positionB = entity->position;
+        cache->rotationB = entity->rotation;
       }
+      continue;
+    }
 
-      // case 023
-      struct v3 v023_normal = v3_cross(v0_to_v2, v0_to_v3);
-      debug_assert(v3_dot(v0_to_v3, v012_normal) >= 0);
-      b8 is_v023_seperated_v1_and_o =
-          v3_dot(o_to_v0, v023_normal) > F32_EPSILON * v0_absoluteNorm * v3_absolute_norm(v023_normal);
-      if (is_v023_seperated_v1_and_o) {
-        // Orient the normal towards O
-        debug_assert(v3_dot(o_to_v0, v023_normal) > 0);
-        struct v3 search_v1_direction = v023_normal;
-        v3_neg_ref(&search_v1_direction);
-
-        // Find a new v2 in that direction
-        v1 = (struct v3){.xy = Support(entityA, entityB, search_v1_direction.xy)};
-        v1_direction = search_v1_direction;
-
-        // Miss detection
-        if (v3_dot(v1, search_v1_direction) < 0) {
-          // detect seperated
-          return 0;
-        }
+    if (cache)
+      cache->distance = 0.0f;
+
+    collision *collision = collisions + collisionCount;
+    collision->pairIndex = pairIndex;
+    collision->entityAIndex = TERRAIN_ENTITY_INDEX;
+    collision->entityBIndex = pair->entityIndex;
+    collision->cache = cache;
+    collision->rule = 0;
+    collision->contact = contact;
+    collisionCount++;
+  }
 
-        // Loop again
-        continue;
+  return collisionCount;
+}
+
+/*
+ * Earliest time of impact of entity with terrain triangles in grid cells its
+ * sweep covers. Triangles are posed as in TerrainNarrowphase().
+ * @param minT earliest time found so far, lowered on hit
+ * @param hit receives triangle posed as static entity, on hit
+ * @return whether triangle is hit before minT
+ */
+static b8
+TerrainTimeOfImpact(terrain *terrain, struct entity *entity, f32 target, f32 *minT, struct entity *hit)
+{
+  struct entity body = {.filter = terrain->filter};
+  if (terrain->triangleCount == 0 || !ShouldEntitiesCollide(&body, entity))
+    return 0;
+
+  // bounding rects of entity at start and end of step enclose its sweep
+  f32 radius = VolumeGetBoundingRadius(entity->volume);
+  rect sweepBound = {
+      .min = V2(Minimum(entity->sweepPosition.x, entity->position.x) - radius,
+                Minimum(entity->sweepPosition.y, entity->position.y) - radius),
+      .max = V2(Maximum(entity->sweepPosition.x, entity->position.x) + radius,
+                Maximum(entity->sweepPosition.y, entity->position.y) + radius),
+  };
+  u32 minX, minY, maxX, maxY;
+  TerrainGetCell(terrain, sweepBound.min, &minX, &minY);
+  TerrainGetCell(terrain, sweepBound.max, &maxX, &maxY);
+
+  b8 isHit = 0;
+  for (u32 cellY = minY; cellY <= maxY; cellY++) {
+    for (u32 cellX = minX; cellX <= maxX; cellX++) {
+      u32 cellIndex = cellY * terrain->cellCountX + cellX;
+      for (u32 offset = terrain->cellOffsets[cellIndex]; offset < terrain->cellOffsets[cellIndex + 1]; offset++) {
+        u32 triangleIndex = terrain->cellTriangles[offset];
+        if (!TerrainIsPairCell(terrain, sweepBound, triangleIndex, cellX, cellY))
+          continue;
+
+        // terrain does not move, its sweep starts where it ends
+        TerrainGetBody(terrain, triangleIndex, &body);
+        body.sweepPosition = body.position;
+        f32 t = TimeOfImpact(entity, &body, target);
+        if (t < *minT) {
+          *minT = t;
+          *hit = body;
+          isHit = 1;
+        }
       }
+    }
+  }
 
-      // No seperation, we are done.
-      break;
+  return isHit;
+}
+
+static void
+EntitySolveTimeOfImpact(struct entity *entities, u32 entityCount, terrain *terrain, u32 bulletIndex, f32 slop)
+{
+  struct entity *bullet = entities + bulletIndex;
+  debug_assert(bullet->isBullet);
+  if (!IsEntityAwake(bullet))
+    return;
+
+  /* Sweep of entity is enclosed by circle at its middle, with radius of
+   * half its motion plus bounding radius. Entities whose circles do not
+   * overlap cannot meet within step.
+   */
+  v2 bulletMotion = v2_sub(bullet->position, bullet->sweepPosition);
+  v2 bulletCenter = v2_add(bullet->sweepPosition, v2_scale(bulletMotion, 0.5f));
+  f32 bulletRadius = VolumeGetBoundingRadius(bullet->volume) + 0.5f * v2_length(bulletMotion);
+
+  f32 minT = 1.0f;
+  // what bullet hits first, entity or terrain triangle as static entity
+  struct entity hit = {};
+  b8 isHit = 0;
+  // entity index 0 is null entity
+  for (u32 entityIndex = 1; entityIndex < entityCount; entityIndex++) {
+    struct entity *entity = entities + entityIndex;
+    if (entity->isBullet || !ShouldEntitiesCollide(bullet, entity))
+      continue;
+
+    v2 motion = v2_sub(entity->position, entity->sweepPosition);
+    v2 center = v2_add(entity->sweepPosition, v2_scale(motion, 0.5f));
+    f32 radius = VolumeGetBoundingRadius(entity->volume) + 0.5f * v2_length(motion);
+    if (v2_length_square(v2_sub(center, bulletCenter)) > Square(radius + bulletRadius))
+      continue;
+
+    f32 t = TimeOfImpact(bullet, entity, slop);
+    if (t < minT) {
+      minT = t;
+      hit = *entity;
+      isHit = 1;
     }
+  }
 
-    // You can safely assume that portal found from now on.
+  if (terrain && TerrainTimeOfImpact(terrain, bullet, slop, &minT, &hit))
+    isHit = 1;
 
-    // Portal refinement
-    for (u32 portalRefinementIteration = 0;; portalRefinementIteration++) {
-      if (portalRefinementIteration == maxIterations) {
-        // iteration limit
-        return 0;
-      }
+  if (!isHit)
+    return;
 
-      // Compute the normal
-      // The v123_normal must be oriented in the same side with O
-      struct v3 v123_normal = v3_cross(v3_sub(v2, v1), v3_sub(v3, v1));
-      if (v3_dot(v123_normal, d) < 0) {
-        swap(v2, v3);
-        swap(v2_direction, v3_direction);
-        v3_neg_ref(&v123_normal);
-      }
+  // sub-step to time of impact, then into contact by slop
+  struct entity posedHit;
+  struct entity posedBullet;
+  EntitySweepAt(&hit, minT, &posedHit);
+  EntitySweepAt(bullet, minT, &posedBullet);
+  v2 pointBullet, pointHit;
+  f32 distance = GJKDistance(&posedBullet, &posedHit, 0, &pointBullet, &pointHit);
+  if (distance > 0.0f) {
+    v2 normal = v2_scale(v2_sub(pointHit, pointBullet), 1.0f / distance);
+    v2_add_ref(&posedBullet.position, v2_scale(normal, distance + slop));
+  }
 
-      // A new point v4 on that direction
-      struct v3 v4 = {.xy = Support(entityA, entityB, v3_normalize(v123_normal).xy)};
-      if (v3_dot(v4, v123_normal) < 0) {
-        return 0;
-      }
+  bullet->position = posedBullet.position;
+  bullet->rotation = posedBullet.rotation;
+  bullet->rotationMatrix = posedBullet.rotationMatrix;
+}
 
-      // Seperation plane very close to the new (candidate) portal
-      // Note that v123_normal can be un-normalized, thus its length
-      // must be considered
-      struct v3 v1_to_v4 = v3_sub(v4, v1);
-      if (Absolute(v3_dot(v1_to_v4, v123_normal)) < tolerance * v3_absolute_norm(v123_normal)) {
-        contact->normal = v123_normal.xy;
-        f32 v123_normal_dot_d = v3_dot(v123_normal, d);
-
-        // Very unlikely case that can not divide the dot
-        if (unlikely(Absolute(v123_normal_dot_d) == 0)) {
-          f32 d_dot_v123[] = {
-              v3_dot(v1, d),
-              v3_dot(v2, d),
-              v3_dot(v3, d),
-          };
-          struct v3 d_for_v123[] = {
-              v1_direction,
-              v2_direction,
-              v3_direction,
-          };
-
-          u32 maxDistanceIndex = 0;
-          f32 maxDistance = d_dot_v123[maxDistanceIndex];
-          for (u32 index = 1; index < ARRAY_COUNT(d_dot_v123); index++) {
-            if (d_dot_v123[index] > maxDistance) {
-              maxDistance = d_dot_v123[index];
-              maxDistanceIndex = index;
-            }
-          }
+static u32
+CollisionColor(memory_arena *memory, struct entity *entities, u32 entityCount, collision *collisions,
+               u32 collisionCount, collision *coloredCollisions, u32 colorOffsets[static COLLISION_COLOR_MAX + 1])
+{
+  // color mask is u64
+  static_assert(COLLISION_COLOR_MAX <= 64);
+
+  memory_temp tempMemory = MemoryTempBegin(memory);
+  // bit n is set when entity has collision with color n
+  u64 *entityColorMasks = MemoryArenaPush(tempMemory.arena, sizeof(*entityColorMasks) * entityCount);
+  u8 *colors = MemoryArenaPush(tempMemory.arena, sizeof(*colors) * collisionCount);
+  bzero(entityColorMasks, sizeof(*entityColorMasks) * entityCount);
+
+  u32 colorCounts[COLLISION_COLOR_MAX] = {};
+  u32 colorCount = 0;
+
+  // greedy, first color that is free on both entities
+  for (u32 collisionIndex = 0; collisionIndex < collisionCount; collisionIndex++) {
+    collision *collision = collisions + collisionIndex;
+    debug_assert(collision->entityAIndex < entityCount && collision->entityBIndex < entityCount);
+    struct entity *entityA = entities + collision->entityAIndex;
+    struct entity *entityB = entities + collision->entityBIndex;
+    b8 isAStatic = IsEntityStatic(entityA);
+    b8 isBStatic = IsEntityStatic(entityB);
+
+    u64 usedColors = 0;
+    if (!isAStatic)
+      usedColors |= entityColorMasks[collision->entityAIndex];
+    if (!isBStatic)
+      usedColors |= entityColorMasks[collision->entityBIndex];
+
+    // last color is overflow, keep its bit clear so it is never used up
+    usedColors |= (u64)1 << COLLISION_COLOR_OVERFLOW;
+    u32 color = COLLISION_COLOR_OVERFLOW;
+    if (usedColors != U64_MAX)
+      color = (u32)__builtin_ctzll(~usedColors);
+
+    if (color != COLLISION_COLOR_OVERFLOW) {
+      u64 colorBit = (u64)1 << color;
+      if (!isAStatic)
+        entityColorMasks[collision->entityAIndex] |= colorBit;
+      if (!isBStatic)
+        entityColorMasks[collision->entityBIndex] |= colorBit;
+    }
 
-          contact->normal = d_for_v123[maxDistanceIndex].xy;
-          contact->depth = maxDistance;
-          contact->start = FindFurthestPoint(entityB, contact->normal);
-          contact->end = FindFurthestPoint(entityA, v2_neg(contact->normal));
-        } else {
-          contact->depth = v3_dot(v4, v123_normal) / v123_normal_dot_d;
-
-          f32 o_to_v1_dot_v123_normal = v3_dot(v1, v123_normal);
-          debug_assert(o_to_v1_dot_v123_normal >= 0);
-          f32 distance_to_v123 = o_to_v1_dot_v123_normal / v123_normal_dot_d;
-
-          struct v3 o_projected = v3_scale(d, distance_to_v123);
-          struct v3 v1_to_v2 = v3_sub(v2, v1);
-          struct v3 v1_to_v3 = v3_sub(v3, v1);
-          struct v3 s1s2s3_planeNormal = v3_cross(v1_to_v2, v1_to_v3);
-          f32 area = v3_length(s1s2s3_planeNormal);
-          f32 s2_weight = v3_length(v3_cross(v1_to_v3, v3_sub(v1, o_projected))) / area;
-          f32 s3_weight = v3_length(v3_cross(v1_to_v2, v3_sub(v1, o_projected))) / area;
-          f32 s1_weight = 1.0f - s2_weight - s3_weight;
-
-          struct v2 aPointsWeighted[] = {
-              v2_scale(FindFurthestPoint(entityA, v1_direction.xy), s1_weight),
-              v2_scale(FindFurthestPoint(entityA, v2_direction.xy), s2_weight),
-              v2_scale(FindFurthestPoint(entityA, v3_direction.xy), s3_weight),
-          };
-          contact->end = v2_add_multiple(ARRAY_COUNT(aPointsWeighted), aPointsWeighted);
-          struct v2 bPointsWeighted[] = {
-              v2_scale(FindFurthestPoint(entityB, v2_neg(v1_direction.xy)), s1_weight),
-              v2_scale(FindFurthestPoint(entityB, v2_neg(v2_direction.xy)), s2_weight),
-              v2_scale(FindFurthestPoint(entityB, v2_neg(v3_direction.xy)), s3_weight),
-          };
-          contact->start = v2_add_multiple(ARRAY_COUNT(bPointsWeighted), bPointsWeighted);
-        }
+    colors[collisionIndex] = (u8)color;
+    colorCounts[color]++;
+    if (color + 1 > colorCount)
+      colorCount = color + 1;
+  }
 
-        return 1;
-      }
+  // counting sort by color, stable so pair order is kept within color
+  u32 offset = 0;
+  for (u32 color = 0; color < colorCount; color++) {
+    colorOffsets[color] = offset;
+    offset += colorCounts[color];
+  }
+  colorOffsets[colorCount] = offset;
+  debug_assert(offset == collisionCount);
+
+  u32 cursors[COLLISION_COLOR_MAX];
+  memcpy(cursors, colorOffsets, sizeof(*cursors) * colorCount);
+  for (u32 collisionIndex = 0; collisionIndex < collisionCount; collisionIndex++) {
+    u32 color = colors[collisionIndex];
+    coloredCollisions[cursors[color]] = collisions[collisionIndex];
+    cursors[color]++;
+  }
 
-      // Update the portal
-
-      // v4 must appear in the next portal
-      // select two in v1, v2 and v3
-      // First do a seperation in with plane v0_v4_o
-      struct v3 o_to_v4 = v4;
-      // struct v3 o_to_v0 = v0;
-      struct v3 o_to_v1 = v1;
-      struct v3 o_to_v2 = v2;
-      struct v3 o_to_v3 = v3;
-
-      struct v3 v0_v4_o_normal = v3_cross(o_to_v4, o_to_v0);
-      if (v3_dot(o_to_v1, v0_v4_o_normal) > 0) {
-        if (v3_dot(o_to_v2, v0_v4_o_normal) > 0) {
-          // Discard v1
-          v1 = v4;
-          v1_direction = v123_normal;
-        } else {
-          // Discard v3
-          v3 = v4;
-          v3_direction = v123_normal;
-        }
-      } else {
-        if (v3_dot(o_to_v3, v0_v4_o_normal) > 0) {
-          // Discard v2
-          v2 = v4;
-          v2_direction = v123_normal;
-        } else {
-          // Discard v1
-          v1 = v4;
-          v1_direction = v123_normal;
-        }
-      }
+  MemoryTempEnd(&tempMemory);
+  return colorCount;
+}
+
+static u32
+IslandFind(u32 *parents, u32 entityIndex)
+{
+  // path halving
+  while (parents[entityIndex] != entityIndex) {
+    parents[entityIndex] = parents[parents[entityIndex]];
+    entityIndex = parents[entityIndex];
+  }
+  return entityIndex;
+}
+
+static void
+IslandUnion(u32 *parents, u32 entityAIndex, u32 entityBIndex)
+{
+  u32 rootA = IslandFind(parents, entityAIndex);
+  u32 rootB = IslandFind(parents, entityBIndex);
+  if (rootA == rootB)
+    return;
+
+  // lower index becomes root, keeps island order independent of collision order
+  if (rootA < rootB)
+    parents[rootB] = rootA;
+  else
+    parents[rootA] = rootB;
+}
+
+static island_list
+IslandBuild(memory_arena *memory, struct entity *entities, u32 entityCount, collision *collisions,
+            u32 collisionCount)
+{
+  island_list result = {};
+  // worst case every entity is island on its own
+  result.islands = MemoryArenaPush(memory, sizeof(*result.islands) * entityCount);
+  result.entityIndices = MemoryArenaPush(memory, sizeof(*result.entityIndices) * entityCount);
+  result.collisions = MemoryArenaPush(memory, sizeof(*result.collisions) * collisionCount);
+
+  memory_temp tempMemory = MemoryTempBegin(memory);
+  u32 *parents = MemoryArenaPush(tempMemory.arena, sizeof(*parents) * entityCount);
+  u32 *entityIslandIndices = MemoryArenaPush(tempMemory.arena, sizeof(*entityIslandIndices) * entityCount);
+
+  for (u32 entityIndex = 0; entityIndex < entityCount; entityIndex++)
+    parents[entityIndex] = entityIndex;
+  entityIslandIndices[0] = U32_MAX;
+
+  for (u32 collisionIndex = 0; collisionIndex < collisionCount; collisionIndex++) {
+    collision *collision = collisions + collisionIndex;
+    if (IsEntityStatic(entities + collision->entityAIndex) || IsEntityStatic(entities + collision->entityBIndex))
+      continue;
+    IslandUnion(parents, collision->entityAIndex, collision->entityBIndex);
+  }
+
+  // number islands in order of their root, root is lowest entity index of island.
+  // entity index 0 is null entity.
+  u32 islandCount = 0;
+  for (u32 entityIndex = 1; entityIndex < entityCount; entityIndex++) {
+    entityIslandIndices[entityIndex] = U32_MAX;
+    if (IsEntityStatic(entities + entityIndex))
+      continue;
+
+    u32 root = IslandFind(parents, entityIndex);
+    if (root == entityIndex) {
+      entityIslandIndices[entityIndex] = islandCount;
+      result.islands[islandCount] = (island){};
+      islandCount++;
+    } else {
+      // root has lower index, already numbered
+      entityIslandIndices[entityIndex] = entityIslandIndices[root];
     }
+    result.islands[entityIslandIndices[entityIndex]].entityCount++;
+  }
 
-    //
-    return 0;
+  u32 islandCollisionCount = 0;
+  for (u32 collisionIndex = 0; collisionIndex < collisionCount; collisionIndex++) {
+    collision *collision = collisions + collisionIndex;
+    u32 islandIndex = entityIslandIndices[collision->entityAIndex];
+    if (islandIndex == U32_MAX)
+      islandIndex = entityIslandIndices[collision->entityBIndex];
+    if (islandIndex == U32_MAX)
+      continue;
+
+    result.islands[islandIndex].collisionCount++;
+    islandCollisionCount++;
+  }
 
-#endif
-  } break;
+  // prefix sums, then counts are refilled as cursors
+  u32 entityOffset = 0;
+  u32 collisionOffset = 0;
+  for (u32 islandIndex = 0; islandIndex < islandCount; islandIndex++) {
+    island *island = result.islands + islandIndex;
+    island->entityOffset = entityOffset;
+    island->collisionOffset = collisionOffset;
+    entityOffset += island->entityCount;
+    collisionOffset += island->collisionCount;
+    island->entityCount = 0;
+    island->collisionCount = 0;
+  }
 
-  default: {
-    breakpoint("don't know how to detect collisition between volumes");
-  }; break;
+  for (u32 entityIndex = 1; entityIndex < entityCount; entityIndex++) {
+    u32 islandIndex = entityIslandIndices[entityIndex];
+    if (islandIndex == U32_MAX)
+      continue;
+
+    island *island = result.islands + islandIndex;
+    result.entityIndices[island->entityOffset + island->entityCount] = entityIndex;
+    island->entityCount++;
   }
 
-  return isColliding;
+  for (u32 collisionIndex = 0; collisionIndex < collisionCount; collisionIndex++) {
+    collision *collision = collisions + collisionIndex;
+    u32 islandIndex = entityIslandIndices[collision->entityAIndex];
+    if (islandIndex == U32_MAX)
+      islandIndex = entityIslandIndices[collision->entityBIndex];
+    if (islandIndex == U32_MAX)
+      continue;
+
+    island *island = result.islands + islandIndex;
+    result.collisions[island->collisionOffset + island->collisionCount] = *collision;
+    island->collisionCount++;
+  }
+
+  result.islandCount = islandCount;
+  result.collisionCount = islandCollisionCount;
+
+  MemoryTempEnd(&tempMemory);
+  return result;
 }
 
 static void
-CollisionResolvePenetration(struct entity *a, struct entity *b, contact *contact)
+IslandUpdateSleep(island_list *islandList, u32 islandIndex, struct entity *entities, f32 dt)
 {
-  /* # THE PROJECTION METHOD
-   * Adjust the "position" of colliding objects.
-   *
-   *   d₁ = depth m₂ / (m₁ + m₂)
-   *   d₂ = depth m₁ / (m₁ + m₂)
-   *
-   * If we apply to convert to using only inverse of mass. Because we may
-   * choose to store only inverse of mass of an entity.
-   *
-   *   d₁ = depth / (1/m₁ + 1/m₂) 1/m₁
-   *   d₂ = depth / (1/m₁ + 1/m₂) 1/m₂
-   *
-   */
-  f32 displacementA = contact->depth / (a->invMass + b->invMass) * a->invMass;
-  f32 displacementB = contact->depth / (a->invMass + b->invMass) * b->invMass;
+  island *island = islandList->islands + islandIndex;
+  u32 *entityIndices = islandList->entityIndices + island->entityOffset;
+
+  f32 minSleepTime = F32_MAX;
+  for (u32 index = 0; index < island->entityCount; index++) {
+    struct entity *entity = entities + entityIndices[index];
+    if (entity->isSleeping)
+      continue;
+
+    if (v2_length_square(entity->velocity) > Square(ENTITY_SLEEP_LINEAR_VELOCITY) ||
+        Absolute(entity->angularVelocity) > ENTITY_SLEEP_ANGULAR_VELOCITY) {
+      entity->sleepTime = 0.0f;
+    } else {
+      entity->sleepTime += dt;
+    }
 
-  v2_sub_ref(&a->position, v2_scale(contact->normal, displacementA));
-  v2_add_ref(&b->position, v2_scale(contact->normal, displacementB));
+    if (entity->sleepTime < minSleepTime)
+      minSleepTime = entity->sleepTime;
+  }
+
+  // already asleep, or one entity is still moving
+  if (minSleepTime == F32_MAX || minSleepTime < ENTITY_SLEEP_TIME)
+    return;
+
+  for (u32 index = 0; index < island->entityCount; index++) {
+    struct entity *entity = entities + entityIndices[index];
+    entity->isSleeping = 1;
+    entity->sleepIslandNext = entityIndices[(index + 1) % island->entityCount];
+    entity->velocity = V2(0.0f, 0.0f);
+    entity->acceleration = V2(0.0f, 0.0f);
+    entity->angularVelocity = 0.0f;
+    entity->angularAcceleration = 0.0f;
+  }
+}
+
+static solver_config
+SolverConfigDefault(void)
+{
+  return (solver_config){
+      .velocityIterations = 8,
+      .positionIterations = 3,
+      .baumgarte = 0.2f,
+      .slop = 0.005f,
+      .maxCorrection = 0.2f,
+      .restitutionThreshold = 0.5f,
+  };
 }
 
+/*
+ * Applies impulse P at point r relative to center of entity.
+ *   ∆v = P / m
+ *   ∆ω = (r × P) / I
+ */
 static void
-CollisionResolve(struct entity *a, struct entity *b, contact *contact)
+EntityApplyImpulseAt(struct entity *entity, v2 impulse, v2 r)
 {
-  CollisionResolvePenetration(a, b, contact);
+  // static entities may be shared between islands solved in parallel
+  if (IsEntityStatic(entity))
+    return;
 
-  /* # THE IMPULSE METHOD
-   *
-   * The impulse generated by the velocity at which two objects collided.
-   *
-   * Therefore we are interested in relative velocity of two objects.
-   * (e.g. Think of two cars on highway going parallel to each other)
-   *
-   *   vRel = v₁ - v₂
-   *
-   * The impluse vector is relative velocity along the collision normal.
-   *
-   *   vRel∙n
-   *   where ∙ is dot product
-   *
-   * Elasticty of collision is
-   *
-   *   v'Rel∙n = -ε (vRel∙n)
-   *   where ε is the coefficient of restitution,
-   *           which determines the elasticity (bounciness) of collision
-   *           [0, 1]
-   *
-   * J is magnitude of impulse
-   *
-   * ∆p₁ = m₁ v'₁ - m₁ v₁ ⇒  Jn = m₁ v'₁ - m₁ v₁ ⇒ v'₁ = v₁ + (Jn / m₁) ┐
-   *                                                                    ├ v'Rel∙n = (v'₁ - v'₂)∙n
-   * ∆p₂ = m₂ v'₂ - m₂ v₂ ⇒ -Jn = m₂ v'₂ - m₂ v₂ ⇒ v'₂ = v₂ - (Jn / m₂) ┘
-   *
-   *       v'Rel = (v₁ - v₂) + (Jn/m₁ + Jn/m₂)
-   *     v'Rel∙n = vRel∙n + (Jn/m₁ + Jn/m₂)∙n
-   *  -ε(vRel∙n) = vRel∙n + Jn(1/m₁ + 1/m₂)∙n
-   *           ┌────────────┘
-   *           J = (-ε(vRel∙n) - (vRel)∙n) / ((1/m₁ + 1/m₂) n∙n)
-   *             = (     -(1 + ε)(vRel∙n)) / ( 1/m₁ + 1/m₂     )
-   *
-   *
-   */
-  f32 e = Minimum(a->restitution, b->restitution);
+  v2_add_ref(&entity->velocity, v2_scale(impulse, entity->invMass));
+  entity->angularVelocity += entity->invI * v2_cross(r, impulse);
+}
+
+/*
+ * Velocity of point r relative to center of entity.
+ *   v_p = v + ω × r
+ */
+static v2
+EntityGetPointVelocity(struct entity *entity, v2 r)
+{
+  return v2_add(entity->velocity, v2_scale(v2_perp(r), entity->angularVelocity));
+}
+
+static void
+SolverPrepare(contact_constraint *constraints, collision *collisions, u32 startIndex, u32 endIndex,
+              struct entity *entities, solver_config *config)
+{
+  for (u32 index = startIndex; index < endIndex; index++) {
+    collision *collision = collisions + index;
+    contact_constraint *constraint = constraints + index;
+    struct entity *a = entities + collision->entityAIndex;
+    struct entity *b = entities + collision->entityBIndex;
+    contact *contact = &collision->contact;
+    pair_cache_entry *cache = collision->cache;
+
+    constraint->entityAIndex = collision->entityAIndex;
+    constraint->entityBIndex = collision->entityBIndex;
+    constraint->normal = contact->normal;
+    constraint->positionA = a->position;
+    constraint->positionB = b->position;
+    constraint->pointCount = contact->pointCount;
+    constraint->cache = cache;
+
+    f32 e = Minimum(a->restitution, b->restitution);
+    if (collision->rule && (collision->rule->flags & PAIR_RULE_RESTITUTION))
+      e = collision->rule->restitution;
+    v2 n = constraint->normal;
+    for (u32 pointIndex = 0; pointIndex < contact->pointCount; pointIndex++) {
+      contact_point *contactPoint = contact->points + pointIndex;
+      contact_constraint_point *point = constraint->points + pointIndex;
+
+      // contact point is half way between deepest points of both entities
+      v2 position = v2_scale(v2_add(contactPoint->start, contactPoint->end), 0.5f);
+      point->rA = v2_sub(position, a->position);
+      point->rB = v2_sub(position, b->position);
+      point->depth = contactPoint->depth;
+      point->id = contactPoint->id;
+
+      // same feature id as in previous frame is same point
+      point->normalImpulse = 0.0f;
+      if (cache) {
+        for (u32 cachedIndex = 0; cachedIndex < cache->pointCount; cachedIndex++) {
+          if (cache->pointIds[cachedIndex] == contactPoint->id) {
+            point->normalImpulse = cache->normalImpulses[cachedIndex];
+            break;
+          }
+        }
+      }
+
+      /* Effective mass along normal n, with contact point offsets r₁ r₂
+       *
+       *   K = 1/m₁ + 1/m₂ + (r₁ × n)²/I₁ + (r₂ × n)²/I₂
+       */
+      f32 rnA = v2_cross(point->rA, n);
+      f32 rnB = v2_cross(point->rB, n);
+      f32 K = a->invMass + b->invMass + a->invI * Square(rnA) + b->invI * Square(rnB);
+      point->normalMass = K > 0.0f ? 1.0f / K : 0.0f;
+
+      /* Restitution
+       *   v'Rel∙n = -ε (vRel∙n)
+       * is target velocity of solver, only for impacts fast enough to bounce.
+       */
+      v2 vRel = v2_sub(EntityGetPointVelocity(b, point->rB), EntityGetPointVelocity(a, point->rA));
+      f32 vn = v2_dot(vRel, n);
+      point->velocityBias = 0.0f;
+      if (vn < -config->restitutionThreshold)
+        point->velocityBias = -e * vn;
+    }
+  }
+}
+
+static void
+SolverWarmStart(contact_constraint *constraints, u32 startIndex, u32 endIndex, struct entity *entities)
+{
+  for (u32 index = startIndex; index < endIndex; index++) {
+    contact_constraint *constraint = constraints + index;
+    struct entity *a = entities + constraint->entityAIndex;
+    struct entity *b = entities + constraint->entityBIndex;
+    for (u32 pointIndex = 0; pointIndex < constraint->pointCount; pointIndex++) {
+      contact_constraint_point *point = constraint->points + pointIndex;
+      v2 P = v2_scale(constraint->normal, point->normalImpulse);
+      EntityApplyImpulseAt(a, v2_neg(P), point->rA);
+      EntityApplyImpulseAt(b, P, point->rB);
+    }
+  }
+}
+
+static void
+SolverStoreImpulses(contact_constraint *constraints, u32 startIndex, u32 endIndex)
+{
+  for (u32 index = startIndex; index < endIndex; index++) {
+    contact_constraint *constraint = constraints + index;
+    pair_cache_entry *cache = constraint->cache;
+    if (!cache)
+      continue;
+
+    cache->pointCount = constraint->pointCount;
+    for (u32 pointIndex = 0; pointIndex < constraint->pointCount; pointIndex++) {
+      contact_constraint_point *point = constraint->points + pointIndex;
+      cache->pointIds[pointIndex] = point->id;
+      cache->normalImpulses[pointIndex] = point->normalImpulse;
+    }
+  }
+}
+
+static void
+SolverSolveVelocity(contact_constraint *constraints, u32 startIndex, u32 endIndex, struct entity *entities)
+{
+  for (u32 index = startIndex; index < endIndex; index++) {
+    contact_constraint *constraint = constraints + index;
+    struct entity *a = entities + constraint->entityAIndex;
+    struct entity *b = entities + constraint->entityBIndex;
+    v2 n = constraint->normal;
+
+    for (u32 pointIndex = 0; pointIndex < constraint->pointCount; pointIndex++) {
+      contact_constraint_point *point = constraint->points + pointIndex;
+
+      /* λ = -(vRel∙n - bias) / K
+       *
+       * Accumulated impulse is clamped instead of λ, so that earlier
+       * iterations that pushed too hard can be undone by later ones.
+       *   Λ' = max(Λ + λ, 0)
+       *   λ  = Λ' - Λ
+       */
+      v2 vRel = v2_sub(EntityGetPointVelocity(b, point->rB), EntityGetPointVelocity(a, point->rA));
+      f32 vn = v2_dot(vRel, n);
+      f32 lambda = -point->normalMass * (vn - point->velocityBias);
+
+      f32 oldImpulse = point->normalImpulse;
+      point->normalImpulse = Maximum(oldImpulse + lambda, 0.0f);
+      lambda = point->normalImpulse - oldImpulse;
+
+      v2 P = v2_scale(n, lambda);
+      EntityApplyImpulseAt(a, v2_neg(P), point->rA);
+      EntityApplyImpulseAt(b, P, point->rB);
+    }
+  }
+}
 
-  // relative velocity
-  v2 vRel = v2_sub(a->velocity, b->velocity);
+static void
+SolverSolvePosition(contact_constraint *constraints, u32 startIndex, u32 endIndex, struct entity *entities,
+                    solver_config *config)
+{
+  for (u32 index = startIndex; index < endIndex; index++) {
+    contact_constraint *constraint = constraints + index;
+    struct entity *a = entities + constraint->entityAIndex;
+    struct entity *b = entities + constraint->entityBIndex;
+    v2 n = constraint->normal;
+
+    f32 invMassSum = a->invMass + b->invMass;
+    if (invMassSum == 0.0f)
+      continue;
+
+    for (u32 pointIndex = 0; pointIndex < constraint->pointCount; pointIndex++) {
+      contact_constraint_point *point = constraint->points + pointIndex;
+
+      /* Penetration is tracked from movement of centers since detection,
+       * so contact does not need to be detected again.
+       *   C = -depth + (∆p₂ - ∆p₁)∙n
+       * Only penetration beyond slop is corrected, by baumgarte fraction.
+       */
+      v2 deltaA = v2_sub(a->position, constraint->positionA);
+      v2 deltaB = v2_sub(b->position, constraint->positionB);
+      f32 separation = -point->depth + v2_dot(v2_sub(deltaB, deltaA), n);
+      f32 C = Clamp(config->baumgarte * (separation + config->slop), -config->maxCorrection, 0.0f);
+      if (C == 0.0f)
+        continue;
+
+      /* # THE PROJECTION METHOD
+       * Moves entities apart along normal, in inverse proportion to their mass.
+       *
+       *   d₁ = C m₂ / (m₁ + m₂)
+       *   d₂ = C m₁ / (m₁ + m₂)
+       *
+       * Entity stores only inverse of mass, so in terms of it
+       *
+       *   d₁ = C / (1/m₁ + 1/m₂) 1/m₁
+       *   d₂ = C / (1/m₁ + 1/m₂) 1/m₂
+       *
+       * Static entity has 1/m = 0 and does not move.
+       */
+      f32 correction = -C / invMassSum;
+      v2 P = v2_scale(n, correction);
+      if (!IsEntityStatic(a))
+        v2_sub_ref(&a->position, v2_scale(P, a->invMass));
+      if (!IsEntityStatic(b))
+        v2_add_ref(&b->position, v2_scale(P, b->invMass));
+    }
+  }
+}
+
+static void
+SolverSolve(solver_config *config, contact_constraint *constraints, u32 constraintCount, struct entity *entities)
+{
+  SolverWarmStart(constraints, 0, constraintCount, entities);
 
-  // impulse vector along the normal
-  f32 impulseMagnitude = -(1.0f + e) * v2_dot(vRel, contact->normal) / (a->invMass + b->invMass);
-  v2 impulseDirection = contact->normal;
+  for (u32 iteration = 0; iteration < config->velocityIterations; iteration++)
+    SolverSolveVelocity(constraints, 0, constraintCount, entities);
 
-  v2 Jn = v2_scale(impulseDirection, impulseMagnitude);
+  for (u32 iteration = 0; iteration < config->positionIterations; iteration++)
+    SolverSolvePosition(constraints, 0, constraintCount, entities, config);
 
-  // apply impluse vector to both objects in opposite direction
-  ApplyImpulse(a, Jn);
-  ApplyImpulse(b, v2_neg(Jn));
+  SolverStoreImpulses(constraints, 0, constraintCount);
 }
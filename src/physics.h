@@ -22,15 +22,36 @@ typedef enum volume_type {
 // Tagged union. see: volume_*
 typedef struct volume {
   volume_type type;
+  u32 index; // shape index in volume_registry, 0 means not registered
 } volume;
 
 typedef struct volume_circle {
   f32 radius;
 } volume_circle;
 
+/* upper bound of verticies, for building contact manifold on stack */
+#define VOLUME_POLYGON_VERTEX_MAX 256
+/* verticies closer than this are merged into one at creation. unit: m */
+#define VOLUME_POLYGON_WELD_DISTANCE 0.005f
+/* polygons with at least this many verticies find support by hill climbing */
+#define VOLUME_POLYGON_HILL_CLIMB_MIN 32
+
+/* support search runs this many verticies at once, see: PolygonSupportIndex() */
+#define VOLUME_POLYGON_SIMD_WIDTH 8
+
 typedef struct volume_polygon {
-  v2 *verticies;
+  v2 *verticies; // counter clockwise, relative to centroid
+  v2 *normals;   // outward normal of edge from vertex i to vertex i+1
+  // verticies in SoA layout, padded to multiple of VOLUME_POLYGON_SIMD_WIDTH
+  f32 *xs;
+  f32 *ys;
   u32 vertexCount;
+  /* MASS PROPERTIES, computed once at creation */
+  f32 area;        // mass is density times area. unit: m²
+  v2 centroid;     // of given verticies, subtracted from them. unit: m
+  f32 unitInertia; // moment of inertia about centroid per unit mass. unit: m²
+  /* BOUNDS, computed once at creation */
+  f32 boundingRadius; // distance of furthest vertex from centroid. unit: m
 } volume_polygon;
 
 typedef struct volume_box {
@@ -38,25 +59,116 @@ typedef struct volume_box {
   f32 height;
 } volume_box;
 
+/*
+ * Triangle with verticies stored inline, no separate allocation like
+ * polygon. Building block of terrain, so kept small.
+ */
+typedef struct volume_triangle {
+  v2 verticies[3]; // counter clockwise, relative to centroid
+  v2 normals[3];   // outward normal of edge from vertex i to vertex i+1
+  /* MASS PROPERTIES, see: volume_polygon */
+  f32 area;
+  v2 centroid;
+  f32 unitInertia;
+  /* BOUNDS, see: volume_polygon */
+  f32 boundingRadius;
+} volume_triangle;
+
 static volume_circle *
 VolumeGetCircle(volume *volume);
 static volume_polygon *
 VolumeGetPolygon(volume *volume);
 static volume_box *
 VolumeGetBox(volume *volume);
+static volume_triangle *
+VolumeGetTriangle(volume *volume);
 
 static volume *
 VolumeCircle(memory_arena *memory, f32 radius);
 
+/*
+ * Convex polygon around given verticies, in any order. Convex hull of
+ * verticies is used, so verticies inside, duplicate or on edges are dropped.
+ * Verticies are moved so centroid is at origin, entity rotates about its
+ * center of mass. Entity placed at polygon's centroid covers given verticies.
+ * @return 0 when verticies have no area or there are more than
+ *         VOLUME_POLYGON_VERTEX_MAX of them
+ */
 static volume *
 VolumePolygon(memory_arena *memory, u32 vertexCount, v2 verticies[static vertexCount]);
 
 static volume *
 VolumeBox(memory_arena *memory, f32 width, f32 height);
 
+/*
+ * Triangle from counter clockwise verticies, centered on its centroid like VolumePolygon().
+ * @return 0 when verticies have no area
+ */
+static volume *
+VolumeTriangle(memory_arena *memory, v2 a, v2 b, v2 c);
+
 static f32
 VolumeGetMomentOfInertia(volume *volume, f32 mass);
 
+/*
+ * Volumes are immutable after creation, so entities with identical shapes
+ * can share one. Registry deduplicates volumes by hashing their type and
+ * parameters, and packs the unique ones contiguously in its own memory.
+ *
+ * Registry holds at most VOLUME_REGISTRY_MAX - 1 volumes. When it is full,
+ * new shapes are not registered and VolumeRegistry*() returns 0, in every
+ * build. Shapes already registered are still found.
+ *
+ * @code
+ *   volume *a = VolumeRegistryBox(registry, 1.0f, 1.0f);
+ *   volume *b = VolumeRegistryBox(registry, 1.0f, 1.0f);
+ *   debug_assert(a == b);
+ * @endcode
+ */
+#define VOLUME_REGISTRY_MAX 256
+#define VOLUME_REGISTRY_SLOT_COUNT (VOLUME_REGISTRY_MAX * 2)
+
+typedef struct volume_registry {
+  memory_arena memory;
+  // index 0 means null volume
+  volume *volumes[VOLUME_REGISTRY_MAX];
+  u32 volumeCount;
+  // open addressing hash table of volume indices, 0 means empty slot
+  u16 slots[VOLUME_REGISTRY_SLOT_COUNT];
+} volume_registry;
+
+static void
+VolumeRegistryInit(volume_registry *registry, memory_arena memory);
+
+static volume *
+VolumeRegistryCircle(volume_registry *registry, f32 radius);
+
+static volume *
+VolumeRegistryPolygon(volume_registry *registry, u32 vertexCount, v2 verticies[static vertexCount]);
+
+static volume *
+VolumeRegistryBox(volume_registry *registry, f32 width, f32 height);
+
+static volume *
+VolumeRegistryTriangle(volume_registry *registry, v2 a, v2 b, v2 c);
+
+static volume *
+VolumeRegistryGet(volume_registry *registry, u32 index);
+
+/*
+ * Entities collide only when category of each is in mask of other.
+ * Entities that share a group override bits: positive group always collides,
+ * negative group never collides. Group 0 means no group.
+ * see: Box2D b2Filter
+ */
+typedef struct collision_filter {
+  u32 categoryBits; // categories entity belongs to
+  u32 maskBits;     // categories entity collides with
+  s32 group;
+} collision_filter;
+
+#define COLLISION_FILTER_DEFAULT ((collision_filter){.categoryBits = 1, .maskBits = U32_MAX, .group = 0})
+
 typedef struct entity {
   /* LINEAR KINEMATICS */
   v2 position;     // unit: m
@@ -68,13 +180,23 @@ typedef struct entity {
 
   /* ANGULAR KINEMATICS */
   f32 rotation;            // θ, unit: rad
+  m2 rotationMatrix;       // cached from rotation, see: EntityUpdateRotation()
   f32 angularVelocity;     // ω, unit: rad/s
   f32 angularAcceleration; // α, unit: rad/s²
   f32 netTorque;           // sum of all torque forces applied
   f32 I;                   // moment of inertia. unit: kg m²
   f32 invI;                // computed from 1/I. unit: kg⁻¹ m⁻²
 
+  /* CONTINUOUS COLLISION */
+  b8 isBullet;         // fast entity, swept against other entities. see: EntitySolveTimeOfImpact()
+  v2 sweepPosition;    // position at start of step
+  f32 sweepRotation;   // rotation at start of step
+
+  collision_filter filter;
   b8 isColliding;
+  b8 isSleeping;
+  f32 sleepTime;       // how long entity has been resting. unit: sec
+  u32 sleepIslandNext; // next entity of island it fell asleep with, in ring. see: EntityWake()
   v4 color;
   volume *volume;
   f32 restitution; // coefficient of elasticity ε, [0, 1]
@@ -82,9 +204,50 @@ typedef struct entity {
 
 #define ENTITY_STATIC_MASS 0.0f
 
+/*
+ * Caches rotation matrix of entity. Must be called whenever rotation
+ * changes, narrowphase only reads the matrix.
+ */
+static void
+EntityUpdateRotation(struct entity *entity);
+
 static b8
 IsEntityStatic(struct entity *entity);
 
+/*
+ * Entity that moves slower than sleep velocities for ENTITY_SLEEP_TIME is
+ * resting. When every entity of its island is resting, whole island falls
+ * asleep. Sleeping entities are not integrated, and pairs without an awake
+ * entity are not tested for collision.
+ *
+ * Entity wakes up when force is applied to it or an awake entity touches it,
+ * together with every entity of island it fell asleep with.
+ * see: IslandUpdateSleep()
+ */
+#define ENTITY_SLEEP_LINEAR_VELOCITY 0.05f  // unit: m/s
+#define ENTITY_SLEEP_ANGULAR_VELOCITY 0.05f // unit: rad/s
+#define ENTITY_SLEEP_TIME 0.5f              // unit: sec
+
+/* Is entity dynamic and not sleeping */
+static b8
+IsEntityAwake(struct entity *entity);
+
+/*
+ * Wakes entity and every entity of island it fell asleep with, so entities
+ * resting on it do not wait for their own pairs to be found. Writes to other
+ * entities, must not run in parallel with anything that touches them.
+ */
+static void
+EntityWake(struct entity *entities, u32 entityIndex);
+
+/*
+ * Checked before any collision test. Pairs of two static entities never
+ * collide, as neither can move the other.
+ * see: collision_filter
+ */
+static b8
+ShouldEntitiesCollide(struct entity *entityA, struct entity *entityB);
+
 /* Generate weight force */
 static v2
 GenerateWeightForce(struct entity *entity);
@@ -126,15 +289,568 @@ GenerateSpringForce(struct entity *entity, v2 anchorPosition, f32 equilibrium, f
 static v2
 GenerateDampingForce(struct entity *entity, f32 k);
 
-typedef struct contact {
-  v2 start;
-  v2 end;
-  v2 normal;
+/*
+ * Contact manifold. Two convex shapes touch either at a point or along an
+ * edge, so 2 points are enough in 2D.
+ *
+ * Every point has feature id made from features of both shapes that created
+ * it. Same id in next frame means same point, which allows solver to start
+ * from impulses of previous frame. see: pair_cache
+ */
+#define CONTACT_POINT_MAX 2
+
+typedef struct contact_point {
+  v2 start; // deepest point of B inside A
+  v2 end;   // deepest point of A inside B
   f32 depth;
+  u32 id;
+} contact_point;
+
+typedef struct contact {
+  v2 normal; // from A to B
+  u32 pointCount;
+  contact_point points[CONTACT_POINT_MAX];
 } contact;
 
+/*
+ * Feature id of point created by clipping incident edge against reference
+ * edge. Incident feature is vertex of incident edge, or side edge of
+ * reference shape that point was clipped at.
+ */
+#define CONTACT_ID(referenceEdge, incidentFeature, isFlipped)                                                         \
+  ((u32)(isFlipped) << 31 | (u32)(referenceEdge) << 16 | (u32)(incidentFeature))
+#define CONTACT_ID_CLIPPED(sideEdge) (0x8000 | (u32)(sideEdge))
+
+/*
+ * Per pair data carried over from previous frame, eg. accumulated impulses
+ * for warm starting solver.
+ *
+ * Cache is double buffered. Every frame pairs found by broadphase are
+ * inserted into current table, taking over their entry from previous table.
+ * Pairs that stopped overlapping are dropped. Insertion is serial, afterwards
+ * every pair owns its entry and may update it from any thread.
+ *
+ * Tables are sized for bounded pair count, not every possible pair. Each
+ * table remembers slots it filled, so swap clears only those instead of whole
+ * table. Inserting beyond pairMax returns 0 in every build, pair is then
+ * solved without warm starting.
+ *
+ * @code
+ *   PairCacheSwap(cache);
+ *   for (u32 pairIndex = 0; pairIndex < pairCount; pairIndex++)
+ *     pairs[pairIndex].cache = PairCacheInsert(cache, pairs[pairIndex].entityAIndex, pairs[pairIndex].entityBIndex);
+ * @endcode
+ */
+/*
+ * Simplex of last GJK query, as vertex indices of both shapes. Next query
+ * of same pair starts from it, with little motion between frames it is
+ * already close to final simplex.
+ */
+typedef struct gjk_simplex_cache {
+  u32 count; // 0 means empty
+  u16 indexA[3];
+  u16 indexB[3];
+} gjk_simplex_cache;
+
+typedef struct pair_cache_entry {
+  u64 key; // 0 means empty slot
+  u32 pointIds[CONTACT_POINT_MAX];
+  f32 normalImpulses[CONTACT_POINT_MAX];
+  u32 pointCount;
+  // edge that separated pair in last frame, see: CollisionDetect()
+  u32 separatingEdge;
+  u32 separatingSupport; // deepest vertex against separating edge, hint for next frame
+  b8 hasSeparatingEdge;
+  b8 isSeparatingEdgeOnB;
+  // deepest vertex of B against first edge of A, and of A against first edge of B.
+  // hints for full search in next frame, see: PolygonFindMaxSeparation()
+  u32 firstSupports[2];
+  // distance of separated pair and where entities were when it was found.
+  // see: Narrowphase()
+  gjk_simplex_cache simplex;
+  f32 distance;
+  v2 positionA;
+  v2 positionB;
+  f32 rotationA;
+  f32 rotationB;
+} pair_cache_entry;
+
+typedef struct pair_cache {
+  pair_cache_entry *tables[2];
+  u32 *filledSlots[2]; // slot indices holding entries, per table
+  u32 filledCounts[2];
+  u32 tableIndex; // current table
+  u32 capacity;   // power of two
+  u32 pairMax;
+} pair_cache;
+
+/* @param pairMax max pairs in one frame, expected not worst case */
+static void
+PairCacheInit(pair_cache *cache, memory_arena *memory, u32 pairMax);
+
+/* Starts new frame, previous frame's pairs become lookup table */
+static void
+PairCacheSwap(pair_cache *cache);
+
+/* @return entry of pair for this frame, 0 if cache is full */
+static pair_cache_entry *
+PairCacheInsert(pair_cache *cache, u32 entityAIndex, u32 entityBIndex);
+
+/* @return entry of entity and terrain triangle for this frame, 0 if cache is full. see: terrain */
+static pair_cache_entry *
+PairCacheInsertTerrain(pair_cache *cache, u32 triangleIndex, u32 entityIndex);
+
+/*
+ * Rules for specific entity pairs, set by game logic, eg. ignore collision
+ * between entities connected by a joint. Broadphase looks up every candidate
+ * pair here.
+ *
+ * Open addressing with linear probing, keyed by entity pair. Removal shifts
+ * following entries back, so table never fills up with tombstones and lookups
+ * stay short. Memory is allocated once at init.
+ *
+ * @code
+ *   pair_rule *rule = PairRuleSet(rules, entityAIndex, entityBIndex);
+ *   rule->flags = PAIR_RULE_IGNORE;
+ *   ...
+ *   // entity destroyed
+ *   PairRuleRemoveEntity(rules, entityAIndex);
+ * @endcode
+ */
+typedef enum pair_rule_flag {
+  PAIR_RULE_IGNORE = 1 << 0,      // pair never collides
+  PAIR_RULE_RESTITUTION = 1 << 1, // pair bounces with rule's restitution instead of entities'
+} pair_rule_flag;
+
+typedef struct pair_rule {
+  u64 key; // 0 means empty slot
+  u32 flags;
+  f32 restitution; // coefficient of elasticity ε, [0, 1], see: PAIR_RULE_RESTITUTION
+} pair_rule;
+
+typedef struct pair_rule_table {
+  pair_rule *rules;
+  u32 capacity; // power of two
+  u32 count;
+} pair_rule_table;
+
+static void
+PairRuleTableInit(pair_rule_table *table, memory_arena *memory, u32 ruleMax);
+
+/* @return rule of pair, created with no flags if it did not exist. 0 if table is full */
+static pair_rule *
+PairRuleSet(pair_rule_table *table, u32 entityAIndex, u32 entityBIndex);
+
+/* @return rule of pair, 0 if there is none */
+static pair_rule *
+PairRuleGet(pair_rule_table *table, u32 entityAIndex, u32 entityBIndex);
+
 static b8
-CollisionDetect(struct entity *a, struct entity *b, contact *contact);
+PairRuleRemove(pair_rule_table *table, u32 entityAIndex, u32 entityBIndex);
+
+/*
+ * Removes every rule that involves entity.
+ * @return number of rules removed
+ */
+static u32
+PairRuleRemoveEntity(pair_rule_table *table, u32 entityIndex);
 
+/* @param cache per pair data that speeds up detection between frames, may be 0 */
+static b8
+CollisionDetect(struct entity *a, struct entity *b, pair_cache_entry *cache, contact *contact);
+
+/*
+ * Closest distance between two convex entities by GJK.
+ * see: Erin Catto - "Computing Distance using GJK" (GDC 2010)
+ *
+ * Circle is a point with radius, so circles and polygons go through same
+ * query.
+ *
+ * @param simplex warm starts query and receives final simplex, may be 0
+ * @param pointA, pointB closest points on A and B, may be 0
+ * @return distance, 0 when overlapping. unit: m
+ */
+static f32
+GJKDistance(struct entity *entityA, struct entity *entityB, gjk_simplex_cache *simplex, v2 *pointA, v2 *pointB);
+
+/*
+ * Time of impact of two entities that move linearly from their sweep pose to
+ * their current pose, by conservative advancement.
+ * see: Brian Mirtich - "Impulse-based Dynamic Simulation of Rigid Body
+ *      Systems" (1996), chapter 2.3
+ *
+ * Distance d between entities, normal n from A to B, can close at most by
+ *   -n∙(∆p_B - ∆p_A) + r_A |∆θ_A| + r_B |∆θ_B|
+ * over whole step. Advancing time by d divided by that never skips contact.
+ *
+ * @param target distance at which entities are considered touching. unit: m
+ * @return fraction of step in [0, 1], 1 when entities do not touch within step
+ *         or already touch at its start
+ */
+static f32
+TimeOfImpact(struct entity *entityA, struct entity *entityB, f32 target);
+
+/*
+ * Radius of circle around volume's origin that encloses volume.
+ * Independent of rotation, so bounds made from it hold for any orientation.
+ */
+static f32
+VolumeGetBoundingRadius(volume *volume);
+
+static rect
+EntityGetBoundingRect(struct entity *entity);
+
+/*
+ * Collision detection is split into two stages.
+ *
+ * Broadphase finds candidate pairs whose bounds overlap. It is cheap and
+ * serial, and orders pairs deterministically.
+ *
+ * Narrowphase runs CollisionDetect() on candidate pairs. Pairs do not depend
+ * on each other, so any range of pairs can be detected on any thread. Every
+ * collision remembers its pair index, which allows outputs from different
+ * threads to be merged back into pair order.
+ *
+ * @code
+ *   u32 pairCount;
+ *   collision_pair *pairs = BroadphaseSweepAndPrune(memory, entities, entityCount, rules, &pairCount);
+ *   collision *collisions = MemoryArenaPush(memory, sizeof(*collisions) * pairCount);
+ *   u32 collisionCount = Narrowphase(entities, pairs, 0, pairCount, collisions);
+ * @endcode
+ */
+typedef struct collision_pair {
+  u32 entityAIndex; // always less than entityBIndex
+  u32 entityBIndex;
+  pair_cache_entry *cache; // may be 0
+  pair_rule *rule;         // may be 0
+} collision_pair;
+
+typedef struct collision {
+  u32 pairIndex;
+  u32 entityAIndex;
+  u32 entityBIndex;
+  pair_cache_entry *cache; // may be 0
+  pair_rule *rule;         // may be 0
+  contact contact;
+} collision;
+
+/*
+ * Sweep and prune along x axis. Entity index 0 is null entity and is skipped.
+ * Pairs without any awake entity are skipped, they cannot move each other.
+ * Pairs rejected by ShouldEntitiesCollide() or ignored by pair rule are
+ * skipped too.
+ * @param rules rules of specific pairs, may be 0
+ * @param pairCount number of candidate pairs found
+ * @return candidate pairs, allocated from memory
+ */
+static collision_pair *
+BroadphaseSweepAndPrune(memory_arena *memory, struct entity *entities, u32 entityCount, pair_rule_table *rules,
+                        u32 *pairCount);
+
+/*
+ * Detects collisions of pairs in range [startIndex, endIndex).
+ * Collisions are written in pair order.
+ * Separated pairs with cache entry remember their GJK distance, and are
+ * skipped until entities could have moved that far.
+ * @param collisions must have space for (endIndex - startIndex) collisions
+ * @return number of collisions written
+ */
+static u32
+Narrowphase(struct entity *entities, collision_pair *pairs, u32 startIndex, u32 endIndex, collision *collisions);
+
+/*
+ * Circle-circle is most common pair type. Broadphase pairs are bucketed so
+ * circle-circle pairs come first, and those are tested without going through
+ * volume type switch.
+ *
+ * @code
+ *   u32 circlePairCount = BroadphaseBucketPairs(memory, entities, pairs, pairCount);
+ *   circle_pack circles = CirclePack(memory, entities, entityCount);
+ *   u32 collisionCount = NarrowphaseCircles(&circles, pairs, 0, circlePairCount, collisions);
+ *   collisionCount += Narrowphase(entities, pairs, circlePairCount, pairCount, collisions + collisionCount);
+ * @endcode
+ */
+
+/* Positions and radii of entities in SoA layout, indexed by entity index. */
+typedef struct circle_pack {
+  f32 *xs;
+  f32 *ys;
+  f32 *radii; // 0 for entities that are not circles
+} circle_pack;
+
+static circle_pack
+CirclePack(memory_arena *memory, struct entity *entities, u32 entityCount);
+
+/*
+ * Moves circle-circle pairs in front of other pairs. Order within both
+ * buckets is kept, so narrowphase output stays deterministic.
+ * @return number of circle-circle pairs
+ */
+static u32
+BroadphaseBucketPairs(memory_arena *memory, struct entity *entities, collision_pair *pairs, u32 pairCount);
+
+/*
+ * Narrowphase() of circle-circle pairs in range [startIndex, endIndex), 8
+ * pairs at a time with AVX2. Collisions are written in pair order.
+ */
+static u32
+NarrowphaseCircles(circle_pack *circles, collision_pair *pairs, u32 startIndex, u32 endIndex, collision *collisions);
+
+/*
+ * Static level geometry made of triangles. Large levels have thousands of
+ * them, as entities every one would go through broadphase each frame.
+ * Terrain keeps its triangles out of entity list, in a uniform grid of its
+ * own. Awake entities look up only cells their bounds overlap, terrain never
+ * tests against itself.
+ *
+ * Triangle that overlaps several cells is listed in each of them. Query
+ * reports it only from the cell where triangle's and entity's bounds start
+ * to overlap, so every pair is found once without marking visited triangles.
+ *
+ * Terrain is not an entity. Its contacts are against null entity, which
+ * stands for static world at origin, so solver and islands treat terrain
+ * like any other static entity. Contact points are in world space.
+ *
+ * @code
+ *   TerrainInit(&terrain, memory, triangleCount, verticies, 4.0f);
+ *   ...
+ *   u32 terrainPairCount;
+ *   terrain_pair *terrainPairs = TerrainBroadphase(memory, &terrain, entities, entityCount, &terrainPairCount);
+ *   for (u32 pairIndex = 0; pairIndex < terrainPairCount; pairIndex++) {
+ *     terrain_pair *pair = terrainPairs + pairIndex;
+ *     pair->cache = PairCacheInsertTerrain(cache, pair->triangleIndex, pair->entityIndex);
+ *   }
+ *   u32 collisionCount = TerrainNarrowphase(&terrain, entities, terrainPairs, 0, terrainPairCount, collisions);
+ * @endcode
+ */
+#define TERRAIN_ENTITY_INDEX 0
+
+typedef struct terrain {
+  volume **triangles; // centered on their centroid, see: VolumeTriangle()
+  v2 *positions;      // centroid of triangle in world space. unit: m
+  rect *bounds;       // of triangle in world space
+  u32 triangleCount;
+  collision_filter filter;
+
+  /* GRID */
+  v2 origin;    // left bottom corner of cell (0, 0)
+  f32 cellSize; // unit: m
+  u32 cellCountX;
+  u32 cellCountY;
+  // triangles of cell are cellTriangles[cellOffsets[cell], cellOffsets[cell + 1]),
+  // cell index is y * cellCountX + x
+  u32 *cellOffsets;
+  u32 *cellTriangles;
+} terrain;
+
+typedef struct terrain_pair {
+  u32 triangleIndex;
+  u32 entityIndex;
+  pair_cache_entry *cache; // may be 0
+} terrain_pair;
+
+/*
+ * Builds terrain from world space triangles, grid covers bounds of all of
+ * them. Triangles without area are dropped.
+ * @param verticies 3 counter clockwise verticies per triangle
+ * @param cellSize unit: m
+ */
+static void
+TerrainInit(terrain *terrain, memory_arena *memory, u32 triangleCount, v2 verticies[static triangleCount * 3],
+            f32 cellSize);
+
+/*
+ * Finds triangles whose bounds overlap bounds of awake entities. Pairs
+ * rejected by ShouldEntitiesCollide() against terrain's filter are skipped.
+ * Pairs are ordered by entity index, then by cell.
+ * @param pairCount number of candidate pairs found
+ * @return candidate pairs, allocated from memory
+ */
+static terrain_pair *
+TerrainBroadphase(memory_arena *memory, terrain *terrain, struct entity *entities, u32 entityCount,
+                  u32 *pairCount);
+
+/*
+ * Narrowphase() of terrain pairs in range [startIndex, endIndex).
+ * Collisions have TERRAIN_ENTITY_INDEX as entity A and are written in pair order.
+ * @param collisions must have space for (endIndex - startIndex) collisions
+ * @return number of collisions written
+ */
+static u32
+TerrainNarrowphase(terrain *terrain, struct entity *entities, terrain_pair *pairs, u32 startIndex, u32 endIndex,
+                   collision *collisions);
+
+/*
+ * Discrete collision detection misses small fast entities passing through
+ * thin ones within one step. Bullet entity at bulletIndex is swept against
+ * every entity that is not a bullet and against terrain triangles in grid
+ * cells its sweep covers, and moved back to earliest time of impact. It is
+ * then pushed slop into what it hits, so narrowphase finds contact and
+ * solver stops it. Rest of step is dropped.
+ *
+ * Only bullet is written, so bullets can be solved in parallel.
+ * @param terrain may be 0
+ */
+static void
+EntitySolveTimeOfImpact(struct entity *entities, u32 entityCount, terrain *terrain, u32 bulletIndex, f32 slop);
+
+/*
+ * Resolving collision writes to both entities, so two collisions that share
+ * an entity cannot be resolved at the same time. Collisions are colored such
+ * that no two collisions with same color share a dynamic entity. Collisions
+ * of one color can then be resolved in parallel, colors one after another.
+ *
+ * Static entities are never written to, so they do not constrain coloring.
+ * Every collision against ground can get the same color.
+ *
+ * Entity with more collisions than there are colors overflows into last
+ * color, which is not independent and must be resolved serially.
+ *
+ * @code
+ *   u32 colorOffsets[COLLISION_COLOR_MAX + 1];
+ *   u32 colorCount = CollisionColor(memory, entities, entityCount, collisions, collisionCount,
+ *                                   coloredCollisions, colorOffsets);
+ *   for (u32 color = 0; color < colorCount; color++) {
+ *     // collisions in [colorOffsets[color], colorOffsets[color + 1])
+ *   }
+ * @endcode
+ */
+#define COLLISION_COLOR_MAX 64
+#define COLLISION_COLOR_OVERFLOW (COLLISION_COLOR_MAX - 1)
+
+/*
+ * @param coloredCollisions collisions grouped by color, in pair order within color
+ * @param colorOffsets start of each color in coloredCollisions, colorOffsets[colorCount] is collisionCount
+ * @return number of colors used
+ */
+static u32
+CollisionColor(memory_arena *memory, struct entity *entities, u32 entityCount, collision *collisions,
+               u32 collisionCount, collision *coloredCollisions, u32 colorOffsets[static COLLISION_COLOR_MAX + 1]);
+
+/*
+ * Island is group of dynamic entities connected by collisions. Resolving one
+ * island never touches entities of another, so islands can be solved on
+ * different threads without any synchronization.
+ *
+ * Static entities do not connect islands, two piles on same ground are two
+ * islands. Every dynamic entity belongs to exactly one island, entity without
+ * collisions is island on its own.
+ *
+ * Islands are ordered by their lowest entity index, entities and collisions
+ * within island keep their original order.
+ */
+typedef struct island {
+  u32 entityOffset; // into island_list.entityIndices
+  u32 entityCount;
+  u32 collisionOffset; // into island_list.collisions
+  u32 collisionCount;
+} island;
+
+typedef struct island_list {
+  island *islands;
+  u32 islandCount;
+  u32 *entityIndices;    // grouped by island
+  collision *collisions; // grouped by island
+  u32 collisionCount;
+} island_list;
+
+/*
+ * Builds islands with union-find over collisions.
+ * Collisions between two static entities belong to no island and are dropped.
+ * @return island list allocated from memory
+ */
+static island_list
+IslandBuild(memory_arena *memory, struct entity *entities, u32 entityCount, collision *collisions,
+            u32 collisionCount);
+
+/*
+ * Sequential impulse contact solver.
+ *
+ * Instead of resolving each contact once, all contacts of an island are
+ * solved over several iterations so that impulses propagate through stacks.
+ * Impulse is accumulated per contact and clamped so that contact can only
+ * push, never pull. Penetration is fixed by separate position iterations
+ * that move bodies directly, this does not add energy to velocities.
+ *
+ * @code
+ *   SolverPrepare(constraints, collisions, 0, collisionCount, entities, config);
+ *   SolverSolve(config, constraints, collisionCount, entities);
+ * @endcode
+ *
+ * see:
+ * - Erin Catto - "Iterative Dynamics with Temporal Coherence" (GDC 2005)
+ * - Erin Catto - "Fast and Simple Physics using Sequential Impulses" (GDC 2006)
+ */
+typedef struct solver_config {
+  u32 velocityIterations;
+  u32 positionIterations;
+  f32 baumgarte;            // fraction of penetration corrected per position iteration, [0, 1]
+  f32 slop;                 // penetration allowed to keep contacts alive. unit: m
+  f32 maxCorrection;        // max position correction per iteration. unit: m
+  f32 restitutionThreshold; // slower impacts do not bounce. unit: m/s
+} solver_config;
+
+static solver_config
+SolverConfigDefault(void);
+
+typedef struct contact_constraint_point {
+  v2 rA; // contact point relative to center of A. unit: m
+  v2 rB; // contact point relative to center of B. unit: m
+  // penetration at detection, changes as bodies move. unit: m
+  f32 depth;
+  f32 normalMass;    // inverse of effective mass along normal
+  f32 velocityBias;  // target separating velocity from restitution. unit: m/s
+  f32 normalImpulse; // accumulated, never negative. unit: kg m/s
+  u32 id;            // feature id, see: contact_point
+} contact_constraint_point;
+
+typedef struct contact_constraint {
+  u32 entityAIndex;
+  u32 entityBIndex;
+  v2 normal; // from A to B
+  // centers at detection, to track penetration in position iterations
+  v2 positionA;
+  v2 positionB;
+  u32 pointCount;
+  contact_constraint_point points[CONTACT_POINT_MAX];
+  pair_cache_entry *cache; // impulses are loaded from and stored to, may be 0
+} contact_constraint;
+
+/* Prepares constraints in range [startIndex, endIndex) from collisions with same index. */
+static void
+SolverPrepare(contact_constraint *constraints, collision *collisions, u32 startIndex, u32 endIndex,
+              struct entity *entities, solver_config *config);
+
+/*
+ * Applies impulses accumulated in previous frame to constraints in range
+ * [startIndex, endIndex). Solver starts close to solution, so stacks settle
+ * with fewer iterations.
+ */
+static void
+SolverWarmStart(contact_constraint *constraints, u32 startIndex, u32 endIndex, struct entity *entities);
+
+/* Stores accumulated impulses of constraints in range [startIndex, endIndex) to pair cache. */
+static void
+SolverStoreImpulses(contact_constraint *constraints, u32 startIndex, u32 endIndex);
+
+/* One velocity iteration over constraints in range [startIndex, endIndex). */
+static void
+SolverSolveVelocity(contact_constraint *constraints, u32 startIndex, u32 endIndex, struct entity *entities);
+
+/* One position iteration over constraints in range [startIndex, endIndex). */
+static void
+SolverSolvePosition(contact_constraint *constraints, u32 startIndex, u32 endIndex, struct entity *entities,
+                    solver_config *config);
+
+/* Runs warm start, all velocity and position iterations and stores impulses serially. */
+static void
+SolverSolve(solver_config *config, contact_constraint *constraints, u32 constraintCount, struct entity *entities);
+
+/*
+ * Accumulates resting time of island's entities, puts island to sleep when
+ * all of them rested long enough. Sleeping entities are linked in ring, so
+ * EntityWake() can wake whole island later.
+ * @param dt time step. unit: sec
+ */
 static void
-CollisionResolve(struct entity *a, struct entity *b, contact *contact);
+IslandUpdateSleep(island_list *islandList, u32 islandIndex, struct entity *entities, f32 dt);
@@ -71,10 +71,94 @@ typedef struct {
   game_controller controllers[3]; // 1 keyboard + 2 controllers
 } game_input;
 
+// Maximum number of threads game code can run on, including main thread.
+#define PLATFORM_THREAD_MAX 8
+
+/*
+ * JOB SYSTEM
+ *
+ * Platform owns a fixed pool of worker threads, each with its own job deque.
+ * Idle threads steal from others, so game can dispatch work without owning
+ * threads.
+ *
+ * Every job callback receives index of thread it runs on. Main thread is 0.
+ * Use it to pick per-thread resources, e.g. scratch arenas.
+ *
+ * Counters track completion. Adding a job with a counter increments it,
+ * finishing the job decrements it. Waiting on a counter runs queued jobs on
+ * calling thread until counter reaches zero, so a job can wait for jobs it
+ * depends on without blocking worker.
+ *
+ * All jobs must be waited before GameUpdateAndRender() returns, because game
+ * library can be reloaded between frames.
+ */
+typedef struct platform_job_queue platform_job_queue;
+
+typedef struct {
+  s32 value; // number of jobs that are not finished
+} platform_job_counter;
+
+typedef void (*pfnPlatformJob)(void *data, u32 threadIndex);
+// Processes indices in [startIndex, endIndex)
+typedef void (*pfnPlatformParallelForJob)(void *data, u32 startIndex, u32 endIndex, u32 threadIndex);
+
+typedef void (*pfnPlatformJobAdd)(platform_job_queue *queue, pfnPlatformJob job, void *data,
+                                  platform_job_counter *counter);
+typedef void (*pfnPlatformJobWait)(platform_job_queue *queue, platform_job_counter *counter);
+typedef void (*pfnPlatformParallelFor)(platform_job_queue *queue, u32 count, u32 batchSize,
+                                       pfnPlatformParallelForJob job, void *data);
+
+typedef struct {
+  platform_job_queue *queue; // 0 means no job system, everything runs on calling thread
+  u32 threadCount;           // including main thread, at most PLATFORM_THREAD_MAX
+
+  pfnPlatformJobAdd JobAdd;
+  pfnPlatformJobWait JobWait;
+  pfnPlatformParallelFor ParallelFor;
+} platform_job_system;
+
+static inline void
+PlatformJobAdd(platform_job_system *jobSystem, pfnPlatformJob job, void *data, platform_job_counter *counter)
+{
+  if (!jobSystem || !jobSystem->queue) {
+    job(data, 0);
+    return;
+  }
+  jobSystem->JobAdd(jobSystem->queue, job, data, counter);
+}
+
+static inline void
+PlatformJobWait(platform_job_system *jobSystem, platform_job_counter *counter)
+{
+  if (!jobSystem || !jobSystem->queue)
+    return;
+  jobSystem->JobWait(jobSystem->queue, counter);
+}
+
+/*
+ * Splits [0, count) into batches of batchSize and runs job on them in
+ * parallel. Returns when all batches are processed.
+ */
+static inline void
+PlatformParallelFor(platform_job_system *jobSystem, u32 count, u32 batchSize, pfnPlatformParallelForJob job,
+                    void *data)
+{
+  if (count == 0)
+    return;
+
+  if (!jobSystem || !jobSystem->queue) {
+    job(data, 0, count, 0);
+    return;
+  }
+  jobSystem->ParallelFor(jobSystem->queue, count, batchSize, job, data);
+}
+
 typedef struct {
   void *permanentStorage; // required to be to zero
   u64 permanentStorageSize;
 
   void *transientStorage;
   u64 transientStorageSize;
+
+  platform_job_system jobSystem;
 } game_memory;
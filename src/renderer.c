@@ -244,6 +244,34 @@ DrawRectRotated(game_renderer *gameRenderer, rect rect, f32 rotation, v4 color)
   SDL_RenderGeometry(renderer, 0, verticies, vertexCount, indices, indexCount);
 }
 
+static void
+DrawConvexPolygon(game_renderer *gameRenderer, v2 *verticies, u32 vertexCount, v4 color)
+{
+  debug_assert(vertexCount >= 3);
+  __cleanup_memory_temp__ memory_temp memory = MemoryTempBegin(&gameRenderer->memory);
+
+  SDL_Vertex *sdlVerticies = MemoryArenaPush(memory.arena, sizeof(*sdlVerticies) * vertexCount);
+  for (u32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
+    v2 vertexInScreenSpace = ToScreenSpace(gameRenderer, verticies[vertexIndex]);
+    sdlVerticies[vertexIndex] = (SDL_Vertex){
+        .position = {vertexInScreenSpace.x, vertexInScreenSpace.y},
+        .color = {color.r, color.g, color.b, color.a},
+    };
+  }
+
+  // triangle fan from first vertex
+  u32 indexCount = (vertexCount - 2) * 3;
+  s32 *indices = MemoryArenaPush(memory.arena, sizeof(*indices) * indexCount);
+  for (u32 triangleIndex = 0; triangleIndex < vertexCount - 2; triangleIndex++) {
+    indices[triangleIndex * 3 + 0] = 0;
+    indices[triangleIndex * 3 + 1] = (s32)triangleIndex + 1;
+    indices[triangleIndex * 3 + 2] = (s32)triangleIndex + 2;
+  }
+
+  SDL_Renderer *renderer = gameRenderer->renderer;
+  SDL_RenderGeometry(renderer, 0, sdlVerticies, (s32)vertexCount, indices, (s32)indexCount);
+}
+
 static void
 DrawCrosshair(game_renderer *gameRenderer, v2 position, f32 dim, v4 color)
 {
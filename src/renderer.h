@@ -41,6 +41,10 @@ DrawRect(game_renderer *renderer, rect rect, v4 color);
 static void
 DrawRectRotated(game_renderer *renderer, rect rect, f32 rotation, v4 color);
 
+/* @param verticies convex, counter clockwise, in world space */
+static void
+DrawConvexPolygon(game_renderer *renderer, v2 *verticies, u32 vertexCount, v4 color);
+
 static void
 DrawCrosshair(game_renderer *renderer, v2 position, f32 dim, v4 color);
 
@@ -49,6 +49,13 @@ output="$outputDir/$(BasenameWithoutExtension "$src")"
 "$cc" $cflags $ldflags $inc -o "$output" $src
 RunTest "$output" "TEST doubly linked list failed."
 
+### memory_test
+inc="-I$ProjectRoot/include"
+src="$pwd/memory_test.c"
+output="$outputDir/$(BasenameWithoutExtension "$src")"
+"$cc" $cflags $ldflags $inc -o "$output" $src
+RunTest "$output" "TEST memory failed."
+
 ### physics_test
 inc="-I$ProjectRoot/include -I$ProjectRoot/src"
 src="$pwd/physics_test.c"
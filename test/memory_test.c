@@ -0,0 +1,214 @@
+#include "memory.h"
+
+// TODO: Show error pretty error message when a test fails
+enum memory_test_error {
+  MEMORY_TEST_ERROR_NONE = 0,
+  MEMORY_TEST_ERROR_ARENA_PUSH_COUNT,
+  MEMORY_TEST_ERROR_ARENA_PEAK_AFTER_TEMP_END,
+  MEMORY_TEST_ERROR_ARENA_PUSH_ALIGNED_WASTED,
+  MEMORY_TEST_ERROR_ARENA_SUB_NAME,
+  MEMORY_TEST_ERROR_POOL_BLOCK_SIZE,
+  MEMORY_TEST_ERROR_POOL_ALLOC_ALIGNED_AND_ZEROED,
+  MEMORY_TEST_ERROR_POOL_FREE_REUSED,
+  MEMORY_TEST_ERROR_POOL_GROW,
+  MEMORY_TEST_ERROR_POOL_FREE_POISONED,
+  MEMORY_TEST_ERROR_SCRATCH_WITHOUT_CONFLICT,
+  MEMORY_TEST_ERROR_SCRATCH_AVOIDS_CONFLICT,
+
+  // src: https://mesonbuild.com/Unit-tests.html#skipped-tests-and-hard-errors
+  // For the default exitcode testing protocol, the GNU standard approach in
+  // this case is to exit the program with error code 77. Meson will detect this
+  // and report these tests as skipped rather than failed. This behavior was
+  // added in version 0.37.0.
+  MESON_TEST_SKIP = 77,
+  // In addition, sometimes a test fails set up so that it should fail even if
+  // it is marked as an expected failure. The GNU standard approach in this case
+  // is to exit the program with error code 99. Again, Meson will detect this
+  // and report these tests as ERROR, ignoring the setting of should_fail. This
+  // behavior was added in version 0.50.0.
+  MESON_TEST_FAILED_TO_SET_UP = 99,
+};
+
+int
+main(void)
+{
+  enum memory_test_error errorCode = MEMORY_TEST_ERROR_NONE;
+
+  // setup
+  enum { KILOBYTES = (1 << 10) };
+  __attribute__((aligned(64))) u8 stackBuffer[8 * KILOBYTES];
+  memory_arena stackMemory = MemoryArena(stackBuffer, ARRAY_COUNT(stackBuffer), "stack");
+  bzero(stackMemory.block, stackMemory.total);
+
+#if IS_BUILD_DEBUG
+  // arena instrumentation only available in debug builds
+
+  // MemoryArenaPush(memory_arena *mem, u64 size)
+  {
+    memory_arena arena = MemoryArenaSub(&stackMemory, 1 * KILOBYTES, "push");
+    MemoryArenaPush(&arena, 16);
+    MemoryArenaPush(&arena, 32);
+    MemoryArenaPush(&arena, 8);
+    if (arena.pushCount != 3 || arena.used != 56 || arena.peak != 56 || arena.wasted != 0) {
+      errorCode = MEMORY_TEST_ERROR_ARENA_PUSH_COUNT;
+      goto end;
+    }
+  }
+
+  // MemoryTempEnd(memory_temp *tempMemory)
+  {
+    memory_arena arena = MemoryArenaSub(&stackMemory, 1 * KILOBYTES, "temp");
+    MemoryArenaPush(&arena, 100);
+    memory_temp tempMemory = MemoryTempBegin(&arena);
+    MemoryArenaPush(tempMemory.arena, 400);
+    MemoryTempEnd(&tempMemory);
+    MemoryArenaPush(&arena, 10);
+
+    // peak must remember the highest usage even after memory is given back
+    if (arena.used != 110 || arena.peak != 500) {
+      errorCode = MEMORY_TEST_ERROR_ARENA_PEAK_AFTER_TEMP_END;
+      goto end;
+    }
+  }
+
+  // MemoryArenaPushAligned(memory_arena *mem, u64 size, u64 alignment)
+  {
+    memory_arena arena = MemoryArenaSub(&stackMemory, 1 * KILOBYTES, "aligned");
+    debug_assert(((u64)arena.block & 63) == 0);
+    MemoryArenaPush(&arena, 4);
+    MemoryArenaPushAligned(&arena, 16, 64);
+    MemoryArenaPushAligned(&arena, 64, 64);
+    if (arena.wasted != 60 + 48 || arena.used != 4 + 60 + 16 + 48 + 64 || arena.pushCount != 3) {
+      errorCode = MEMORY_TEST_ERROR_ARENA_PUSH_ALIGNED_WASTED;
+      goto end;
+    }
+  }
+
+  // MemoryArenaSub(memory_arena *master, u64 size, const char *name)
+  {
+    memory_arena arena = MemoryArenaSub(&stackMemory, 1 * KILOBYTES, "sub");
+    if (arena.name[0] != 's' || arena.name[1] != 'u' || arena.name[2] != 'b' || arena.used != 0 ||
+        arena.total != 1 * KILOBYTES ||
+        // each sub arena counts as push in master
+        stackMemory.pushCount != 4 || stackMemory.used != 4 * KILOBYTES) {
+      errorCode = MEMORY_TEST_ERROR_ARENA_SUB_NAME;
+      goto end;
+    }
+  }
+#endif
+
+  // MemoryPool(memory_arena *arena, u64 size, u32 blocksPerChunk)
+  {
+    struct test_case {
+      u64 size;
+      u64 expected;
+    } testCases[] = {
+        {.size = 1, .expected = 8},     {.size = 8, .expected = 8},     {.size = 12, .expected = 16},
+        {.size = 33, .expected = 64},   {.size = 64, .expected = 64},   {.size = 65, .expected = 128},
+        {.size = 200, .expected = 256},
+    };
+    for (u32 testCaseIndex = 0; testCaseIndex < ARRAY_COUNT(testCases); testCaseIndex++) {
+      struct test_case *testCase = testCases + testCaseIndex;
+      memory_pool pool = MemoryPool(&stackMemory, testCase->size, 4);
+      if (pool.blockSize != testCase->expected) {
+        errorCode = MEMORY_TEST_ERROR_POOL_BLOCK_SIZE;
+        goto end;
+      }
+    }
+  }
+
+  // MemoryPoolAlloc(memory_pool *pool)
+  {
+    struct record {
+      f32 x, y, z;
+    };
+
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    memory_pool pool = MemoryPoolOf(tempMemory.arena, struct record, 4);
+
+    struct record *a = MemoryPoolAllocType(&pool, struct record);
+    struct record *b = MemoryPoolAllocType(&pool, struct record);
+    if (((u64)a & (pool.blockSize - 1)) != 0 || (u8 *)b - (u8 *)a != (s64)pool.blockSize || a->x != 0.0f ||
+        a->y != 0.0f || a->z != 0.0f || pool.used != 2 || pool.total != 4) {
+      errorCode = MEMORY_TEST_ERROR_POOL_ALLOC_ALIGNED_AND_ZEROED;
+      goto end;
+    }
+  }
+
+  // MemoryPoolFree(memory_pool *pool, void *memory)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    memory_pool pool = MemoryPool(tempMemory.arena, 24, 4);
+
+    u8 *a = MemoryPoolAlloc(&pool);
+    MemoryPoolAlloc(&pool);
+    a[0] = 0xff;
+    u64 usedMemoryBefore = tempMemory.arena->used;
+    MemoryPoolFree(&pool, a);
+    u8 *c = MemoryPoolAlloc(&pool);
+
+    // no allocation allowed, most recently freed block must be reused and zeroed
+    if (c != a || c[0] != 0 || pool.used != 2 || tempMemory.arena->used != usedMemoryBefore) {
+      errorCode = MEMORY_TEST_ERROR_POOL_FREE_REUSED;
+      goto end;
+    }
+  }
+
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    memory_pool pool = MemoryPool(tempMemory.arena, 128, 2);
+
+    MemoryPoolAlloc(&pool);
+    MemoryPoolAlloc(&pool);
+    u64 usedMemoryBefore = tempMemory.arena->used;
+    u8 *c = MemoryPoolAlloc(&pool);
+    if (pool.total != 4 || pool.used != 3 || tempMemory.arena->used != usedMemoryBefore + 2 * 128 ||
+        ((u64)c & (CACHE_LINE_SIZE - 1)) != 0) {
+      errorCode = MEMORY_TEST_ERROR_POOL_GROW;
+      goto end;
+    }
+  }
+
+#if IS_BUILD_DEBUG
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    memory_pool pool = MemoryPool(tempMemory.arena, 32, 2);
+
+    u8 *a = MemoryPoolAlloc(&pool);
+    MemoryPoolFree(&pool, a);
+    if (a[sizeof(struct memory_pool_block)] != MEMORY_POOL_POISON || a[pool.blockSize - 1] != MEMORY_POOL_POISON) {
+      errorCode = MEMORY_TEST_ERROR_POOL_FREE_POISONED;
+      goto end;
+    }
+  }
+#endif
+
+  // MemoryScratchBegin(memory_arena *scratches, u32 scratchCount, memory_arena **conflicts, u32 conflictCount)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    memory_arena scratches[MEMORY_SCRATCH_PER_THREAD];
+    for (u32 scratchIndex = 0; scratchIndex < ARRAY_COUNT(scratches); scratchIndex++)
+      scratches[scratchIndex] = MemoryArenaSub(tempMemory.arena, 256, "scratch");
+
+    memory_temp scratch = MemoryScratchBegin(scratches, ARRAY_COUNT(scratches), 0, 0);
+    MemoryArenaPush(scratch.arena, 64);
+    if (scratch.arena != scratches + 0 || scratches[0].used != 64) {
+      errorCode = MEMORY_TEST_ERROR_SCRATCH_WITHOUT_CONFLICT;
+      goto end;
+    }
+
+    // callee gets scratch arena of caller as result arena
+    memory_arena *conflicts[] = {scratch.arena};
+    memory_temp calleeScratch = MemoryScratchBegin(scratches, ARRAY_COUNT(scratches), conflicts, ARRAY_COUNT(conflicts));
+    MemoryArenaPush(calleeScratch.arena, 32);
+    MemoryTempEnd(&calleeScratch);
+    if (calleeScratch.arena != scratches + 1 || scratches[0].used != 64 || scratches[1].used != 0) {
+      errorCode = MEMORY_TEST_ERROR_SCRATCH_AVOIDS_CONFLICT;
+      goto end;
+    }
+    MemoryTempEnd(&scratch);
+  }
+
+end:
+  return (int)errorCode;
+}
@@ -34,7 +34,34 @@
   X(PHYSICS_TEST_ERROR_FINDFURTHESTPOINT_CIRCLE_CENTER_UP,                                                             \
     "Finding furthest point for circle volume in direction of center up failed.")                                      \
   X(PHYSICS_TEST_ERROR_FINDFURTHESTPOINT_CIRCLE_CENTER_DOWN,                                                           \
-    "Finding furthest point for circle volume in direction of center down failed.")
+    "Finding furthest point for circle volume in direction of center down failed.")                                 \
+  X(PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DEDUPLICATE, "Registering identical volumes must return same volume.")          \
+  X(PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DISTINCT, "Registering different volumes must return different volumes.")   \
+  X(PHYSICS_TEST_ERROR_BROADPHASE_PAIRS, "Broadphase must find only pairs with overlapping bounds.")                 \
+  X(PHYSICS_TEST_ERROR_NARROWPHASE_COLLISIONS, "Narrowphase must report only colliding pairs in pair order.")      \
+  X(PHYSICS_TEST_ERROR_COLLISIONCOLOR_SHARED, "Collisions with same color must not share a dynamic entity.")          \
+  X(PHYSICS_TEST_ERROR_COLLISIONCOLOR_STATIC, "Static entities must not constrain collision coloring.")           \
+  X(PHYSICS_TEST_ERROR_ISLANDBUILD, "Islands must group dynamic entities connected by collisions.")              \
+  X(PHYSICS_TEST_ERROR_ISLANDSLEEP, "Island must sleep only when all of its entities rested long enough.")       \
+  X(PHYSICS_TEST_ERROR_SOLVER_VELOCITY, "Solver must stop approaching velocity at contact.")                         \
+  X(PHYSICS_TEST_ERROR_SOLVER_POSITION, "Solver must reduce penetration without pulling entities together.")    \
+  X(PHYSICS_TEST_ERROR_CONTACT_MANIFOLD, "Resting box must touch along edge with two points of distinct ids.")      \
+  X(PHYSICS_TEST_ERROR_PAIRCACHE, "Pair cache must carry over entries of pairs found again, reject pairs when full.") \
+  X(PHYSICS_TEST_ERROR_SEPARATING_AXIS, "Separating edge must be cached while pair is apart, support hints kept.")     \
+  X(PHYSICS_TEST_ERROR_CIRCLE_BOX, "Circle must touch rotated box at closest point of box.")                          \
+  X(PHYSICS_TEST_ERROR_CIRCLE_POLYGON, "Circle must touch polygon at closest edge or vertex.")                       \
+  X(PHYSICS_TEST_ERROR_POLYGON_SUPPORT, "Polygon support search must return real vertex furthest along direction.") \
+  X(PHYSICS_TEST_ERROR_POLYGON_HILL_CLIMB, "Hill climbing must reach support vertex from any starting vertex.")    \
+  X(PHYSICS_TEST_ERROR_GJK_DISTANCE, "GJK must find distance and closest points of separated entities.")     \
+  X(PHYSICS_TEST_ERROR_TIME_OF_IMPACT, "Bullet must stop at box or terrain it would pass through within one step.") \
+  X(PHYSICS_TEST_ERROR_NARROWPHASE_CIRCLES, "Batched circle narrowphase must match generic narrowphase.")            \
+  X(PHYSICS_TEST_ERROR_COLLISION_FILTER, "Pairs must be filtered by category, mask, group and static entities.")  \
+  X(PHYSICS_TEST_ERROR_PAIR_RULE, "Pair rules must be found until removed with their pair or entity.")          \
+  X(PHYSICS_TEST_ERROR_POLYGON_MASS, "Polygon must be centered on centroid with area and inertia of its shape.")     \
+  X(PHYSICS_TEST_ERROR_TRIANGLE, "Triangle must be one allocation and collide like polygon of same verticies.")   \
+  X(PHYSICS_TEST_ERROR_CONVEX_HULL, "Polygon must keep only hull verticies, reject no area or too many verticies.") \
+  X(PHYSICS_TEST_ERROR_TERRAIN, "Terrain must pair awake entities once with every triangle their bounds overlap.")     \
+  X(PHYSICS_TEST_ERROR_ISLANDWAKE, "Waking entity must wake every entity of island it fell asleep with.")
 
 enum physics_test_error {
   PHYSICS_TEST_ERROR_NONE = 0,
@@ -110,6 +137,7 @@ main(void)
         .position = position,
         .volume = VolumeBox(tempMemory.arena, size.x, size.y),
     };
+    EntityUpdateRotation(&entity);
 
     // vertex positions
     v2 topRight = v2_add(position, halfSize);
@@ -294,5 +322,936 @@ main(void)
     }
   }
 
+  // volume *VolumeRegistryBox(volume_registry *registry, f32 width, f32 height)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume_registry *registry = MemoryArenaPush(tempMemory.arena, sizeof(*registry));
+    VolumeRegistryInit(registry, MemoryArenaSub(tempMemory.arena, 1024, "volumes"));
+
+    v2 triangle[] = {V2(0.0f, 0.0f), V2(1.0f, 0.0f), V2(0.0f, 1.0f)};
+    volume *boxA = VolumeRegistryBox(registry, 1.0f, 1.0f);
+    volume *circleA = VolumeRegistryCircle(registry, 1.0f);
+    volume *polygonA = VolumeRegistryPolygon(registry, ARRAY_COUNT(triangle), triangle);
+    u64 usedMemoryBefore = registry->memory.used;
+    volume *boxB = VolumeRegistryBox(registry, 1.0f, 1.0f);
+    volume *circleB = VolumeRegistryCircle(registry, 1.0f);
+    volume *polygonB = VolumeRegistryPolygon(registry, ARRAY_COUNT(triangle), triangle);
+
+    if (boxA != boxB || circleA != circleB || polygonA != polygonB ||
+        // duplicates must not use memory
+        registry->memory.used != usedMemoryBefore || registry->volumeCount != 1 + 3 ||
+        VolumeRegistryGet(registry, boxA->index) != boxA) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DEDUPLICATE);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DEDUPLICATE;
+    }
+
+    v2 otherTriangle[] = {V2(0.0f, 0.0f), V2(2.0f, 0.0f), V2(0.0f, 1.0f)};
+    if (VolumeRegistryBox(registry, 1.0f, 2.0f) == boxA || VolumeRegistryBox(registry, 2.0f, 1.0f) == boxA ||
+        VolumeRegistryCircle(registry, 0.5f) == circleA ||
+        VolumeRegistryPolygon(registry, ARRAY_COUNT(otherTriangle), otherTriangle) == polygonA ||
+        registry->volumeCount != 1 + 3 + 4) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DISTINCT);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DISTINCT;
+    }
+
+    // -0 equals 0, so must be found in same slot
+    volume *zeroTriangle = VolumeRegistryTriangle(registry, V2(-1.0f, 0.0f), V2(1.0f, 0.0f), V2(0.0f, 3.0f));
+    volume *negativeZeroTriangle =
+        VolumeRegistryTriangle(registry, V2(-1.0f, 0.0f), V2(1.0f, 0.0f), V2(-0.0f, 3.0f));
+
+    // full registry does not register new shapes, but still finds registered ones
+    registry->volumeCount = VOLUME_REGISTRY_MAX;
+    u64 usedMemoryFull = registry->memory.used;
+    b8 isFullHandled = VolumeRegistryCircle(registry, 3.0f) == 0 && registry->memory.used == usedMemoryFull &&
+                       VolumeRegistryCircle(registry, 1.0f) == circleA;
+
+    if (zeroTriangle != negativeZeroTriangle || !isFullHandled) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DEDUPLICATE);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_VOLUMEREGISTRY_DEDUPLICATE;
+    }
+  }
+
+  // collision_pair *BroadphaseSweepAndPrune(memory_arena *memory, struct entity *entities, u32 entityCount,
+  //                                         pair_rule_table *rules, u32 *pairCount)
+  // u32 Narrowphase(struct entity *entities, collision_pair *pairs, u32 startIndex, u32 endIndex, collision
+  // *collisions)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *circle = VolumeCircle(tempMemory.arena, 1.0f);
+    volume *box = VolumeBox(tempMemory.arena, 2.0f, 2.0f);
+
+    // index 0 is null entity
+    struct entity entities[6] = {};
+    entities[1] = (struct entity){.position = V2(10.0f, 0.0f), .volume = circle, .invMass = 1.0f};
+    entities[2] = (struct entity){.position = V2(0.0f, 0.0f), .volume = circle, .invMass = 1.0f};
+    entities[3] = (struct entity){.position = V2(-1.5f, 0.0f), .volume = circle, .invMass = 1.0f};
+    // bounds overlap with entity 2, but circles do not touch
+    entities[4] = (struct entity){.position = V2(1.5f, 1.5f), .volume = circle, .invMass = 1.0f};
+    // same x as entity 2 but far away in y axis
+    entities[5] = (struct entity){.position = V2(0.0f, 10.0f), .volume = box, .invMass = 1.0f};
+    EntityUpdateRotation(entities + 5);
+    for (u32 entityIndex = 1; entityIndex < ARRAY_COUNT(entities); entityIndex++)
+      entities[entityIndex].filter = COLLISION_FILTER_DEFAULT;
+
+    u32 pairCount;
+    collision_pair *pairs =
+        BroadphaseSweepAndPrune(tempMemory.arena, entities, ARRAY_COUNT(entities), 0, &pairCount);
+    b8 isPairsCorrect = pairCount == 2;
+    for (u32 pairIndex = 0; isPairsCorrect && pairIndex < pairCount; pairIndex++) {
+      collision_pair *pair = pairs + pairIndex;
+      isPairsCorrect = pair->entityAIndex == 2 && (pair->entityBIndex == 3 || pair->entityBIndex == 4);
+    }
+    if (!isPairsCorrect) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_BROADPHASE_PAIRS);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_BROADPHASE_PAIRS;
+    } else {
+      collision collisions[2];
+      u32 collisionCount = Narrowphase(entities, pairs, 0, pairCount, collisions);
+      if (collisionCount != 1 || collisions[0].entityAIndex != 2 || collisions[0].entityBIndex != 3 ||
+          pairs[collisions[0].pairIndex].entityBIndex != 3) {
+        StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_NARROWPHASE_COLLISIONS);
+        StringBuilderAppendStringLiteral(sb, "\n");
+        string message = StringBuilderFlush(sb);
+        LogMessage(&message);
+
+        errorCode = PHYSICS_TEST_ERROR_NARROWPHASE_COLLISIONS;
+      }
+    }
+  }
+
+  // u32 CollisionColor(memory_arena *memory, struct entity *entities, u32 entityCount, collision *collisions,
+  //                    u32 collisionCount, collision *coloredCollisions, u32 colorOffsets[COLLISION_COLOR_MAX + 1])
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+
+    // entities 1-4 are dynamic, 5 is static ground
+    struct entity entities[6] = {};
+    for (u32 entityIndex = 1; entityIndex < 5; entityIndex++)
+      entities[entityIndex].invMass = 1.0f;
+
+    // chain 1-2-3-4 and every dynamic entity resting on ground
+    collision collisions[] = {
+        {.entityAIndex = 1, .entityBIndex = 2}, {.entityAIndex = 2, .entityBIndex = 3},
+        {.entityAIndex = 3, .entityBIndex = 4}, {.entityAIndex = 1, .entityBIndex = 5},
+        {.entityAIndex = 2, .entityBIndex = 5}, {.entityAIndex = 3, .entityBIndex = 5},
+        {.entityAIndex = 4, .entityBIndex = 5},
+    };
+    for (u32 collisionIndex = 0; collisionIndex < ARRAY_COUNT(collisions); collisionIndex++)
+      collisions[collisionIndex].pairIndex = collisionIndex;
+
+    collision coloredCollisions[ARRAY_COUNT(collisions)];
+    u32 colorOffsets[COLLISION_COLOR_MAX + 1];
+    u32 colorCount = CollisionColor(tempMemory.arena, entities, ARRAY_COUNT(entities), collisions,
+                                    ARRAY_COUNT(collisions), coloredCollisions, colorOffsets);
+
+    b8 isShared = colorOffsets[colorCount] != ARRAY_COUNT(collisions);
+    for (u32 color = 0; !isShared && color < colorCount; color++) {
+      for (u32 index = colorOffsets[color]; index < colorOffsets[color + 1]; index++) {
+        for (u32 otherIndex = index + 1; otherIndex < colorOffsets[color + 1]; otherIndex++) {
+          collision *a = coloredCollisions + index;
+          collision *b = coloredCollisions + otherIndex;
+          u32 aEntities[] = {a->entityAIndex, a->entityBIndex};
+          u32 bEntities[] = {b->entityAIndex, b->entityBIndex};
+          for (u32 i = 0; i < 2; i++) {
+            for (u32 j = 0; j < 2; j++) {
+              if (aEntities[i] == bEntities[j] && !IsEntityStatic(entities + aEntities[i]))
+                isShared = 1;
+            }
+          }
+        }
+      }
+    }
+    if (isShared) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_COLLISIONCOLOR_SHARED);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_COLLISIONCOLOR_SHARED;
+    }
+
+    // chain needs 2 colors, each entity touching ground adds one more
+    if (colorCount != 3) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_COLLISIONCOLOR_STATIC);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_COLLISIONCOLOR_STATIC;
+    }
+  }
+
+  // island_list IslandBuild(memory_arena *memory, struct entity *entities, u32 entityCount, collision *collisions,
+  //                         u32 collisionCount)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+
+    // entities 1-5 are dynamic, 6 is static ground
+    struct entity entities[7] = {};
+    for (u32 entityIndex = 1; entityIndex < 6; entityIndex++)
+      entities[entityIndex].invMass = 1.0f;
+
+    // piles {1, 2} and {4, 5} on same ground, 3 is alone
+    collision collisions[] = {
+        {.entityAIndex = 4, .entityBIndex = 5},
+        {.entityAIndex = 2, .entityBIndex = 6},
+        {.entityAIndex = 1, .entityBIndex = 2},
+        {.entityAIndex = 4, .entityBIndex = 6},
+    };
+
+    island_list islandList =
+        IslandBuild(tempMemory.arena, entities, ARRAY_COUNT(entities), collisions, ARRAY_COUNT(collisions));
+    island *islands = islandList.islands;
+    u32 *entityIndices = islandList.entityIndices;
+    if (islandList.islandCount != 3 || islandList.collisionCount != ARRAY_COUNT(collisions) ||
+        // {1, 2}
+        islands[0].entityCount != 2 || entityIndices[islands[0].entityOffset] != 1 ||
+        entityIndices[islands[0].entityOffset + 1] != 2 || islands[0].collisionCount != 2 ||
+        islandList.collisions[islands[0].collisionOffset].entityBIndex != 6 ||
+        // {3}
+        islands[1].entityCount != 1 || entityIndices[islands[1].entityOffset] != 3 || islands[1].collisionCount != 0 ||
+        // {4, 5}
+        islands[2].entityCount != 2 || entityIndices[islands[2].entityOffset] != 4 ||
+        islands[2].collisionCount != 2 || islandList.collisions[islands[2].collisionOffset].entityBIndex != 5) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_ISLANDBUILD);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_ISLANDBUILD;
+    }
+
+    // void IslandUpdateSleep(island_list *islandList, u32 islandIndex, struct entity *entities, f32 dt)
+    entities[1].velocity = V2(ENTITY_SLEEP_LINEAR_VELOCITY * 0.5f, 0.0f);
+    entities[2].velocity = V2(0.0f, 0.0f);
+    entities[4].velocity = V2(0.0f, 0.0f);
+    // keeps island {4, 5} awake
+    entities[5].angularVelocity = ENTITY_SLEEP_ANGULAR_VELOCITY * 2.0f;
+
+    f32 dt = ENTITY_SLEEP_TIME / 4.0f;
+    b8 isSleptEarly = 0;
+    for (u32 step = 0; step < 5; step++) {
+      for (u32 islandIndex = 0; islandIndex < islandList.islandCount; islandIndex++)
+        IslandUpdateSleep(&islandList, islandIndex, entities, dt);
+      if (step < 3 && entities[1].isSleeping)
+        isSleptEarly = 1;
+    }
+
+    if (isSleptEarly || !entities[1].isSleeping || !entities[2].isSleeping || entities[1].velocity.x != 0.0f ||
+        entities[4].isSleeping || entities[5].isSleeping || IsEntityAwake(entities + 1) ||
+        !IsEntityAwake(entities + 4) || IsEntityAwake(entities + 6)) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_ISLANDSLEEP);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_ISLANDSLEEP;
+    }
+
+    // void EntityWake(struct entity *entities, u32 entityIndex)
+    // touching 2 wakes 1 resting on it, 3 fell asleep on its own
+    b8 isThirdSleeping = entities[3].isSleeping;
+    EntityWake(entities, 2);
+    if (!isThirdSleeping || !IsEntityAwake(entities + 1) || !IsEntityAwake(entities + 2) || !entities[3].isSleeping ||
+        entities[1].sleepTime != 0.0f) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_ISLANDWAKE);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_ISLANDWAKE;
+    }
+  }
+
+  // void SolverSolve(solver_config *config, contact_constraint *constraints, u32 constraintCount,
+  //                  struct entity *entities)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *circle = VolumeCircle(tempMemory.arena, 1.0f);
+
+    // dynamic circle falling onto static circle, penetrating by 0.1m
+    struct entity entities[3] = {};
+    entities[1] = (struct entity){.position = V2(0.0f, 0.0f), .volume = circle};
+    entities[2] = (struct entity){
+        .position = V2(0.0f, 1.9f),
+        .velocity = V2(0.0f, -3.0f),
+        .mass = 1.0f,
+        .invMass = 1.0f,
+        .invI = Inverse(VolumeGetMomentOfInertia(circle, 1.0f)),
+        .volume = circle,
+    };
+
+    collision collision = {.entityAIndex = 1, .entityBIndex = 2};
+    b8 isColliding = CollisionDetect(entities + 1, entities + 2, 0, &collision.contact);
+
+    solver_config config = SolverConfigDefault();
+    contact_constraint constraint;
+    SolverPrepare(&constraint, &collision, 0, 1, entities, &config);
+    SolverSolve(&config, &constraint, 1, entities);
+
+    // restitution is 0, entity must come to rest along normal
+    if (!isColliding || Absolute(entities[2].velocity.y) > 0.0001f || Absolute(entities[2].velocity.x) > 0.0001f ||
+        constraint.points[0].normalImpulse < 0.0f || entities[1].velocity.y != 0.0f) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_SOLVER_VELOCITY);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_SOLVER_VELOCITY;
+    }
+
+    f32 depth = 2.0f - entities[2].position.y;
+    if (depth >= 0.1f || depth < config.slop || entities[1].position.y != 0.0f) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_SOLVER_POSITION);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_SOLVER_POSITION;
+    }
+  }
+
+  // b8 CollisionDetect(struct entity *a, struct entity *b, pair_cache_entry *cache, contact *contact)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *ground = VolumeBox(tempMemory.arena, 4.0f, 1.0f);
+    volume *box = VolumeBox(tempMemory.arena, 2.0f, 1.0f);
+
+    // box resting on ground, penetrating by 0.1m
+    struct entity groundEntity = {.position = V2(0.0f, 0.0f), .volume = ground};
+    struct entity boxEntity = {.position = V2(0.5f, 0.9f), .volume = box};
+    EntityUpdateRotation(&groundEntity);
+    EntityUpdateRotation(&boxEntity);
+    contact contact;
+    b8 isColliding = CollisionDetect(&groundEntity, &boxEntity, 0, &contact);
+
+    b8 isPointsValid = isColliding && contact.pointCount == 2;
+    for (u32 pointIndex = 0; isPointsValid && pointIndex < contact.pointCount; pointIndex++) {
+      contact_point *point = contact.points + pointIndex;
+      if (Absolute(point->depth - 0.1f) > 0.001f || Absolute(point->start.y - 0.4f) > 0.001f ||
+          Absolute(point->end.y - 0.5f) > 0.001f)
+        isPointsValid = 0;
+    }
+
+    if (!isPointsValid || Absolute(contact.normal.x) > 0.001f || Absolute(contact.normal.y - 1.0f) > 0.001f ||
+        contact.points[0].id == contact.points[1].id) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_CONTACT_MANIFOLD);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_CONTACT_MANIFOLD;
+    }
+  }
+
+  // b8 CollisionDetect(struct entity *a, struct entity *b, pair_cache_entry *cache, contact *contact)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *box = VolumeBox(tempMemory.arena, 1.0f, 1.0f);
+
+    // rotated box 1m to the right of other box
+    struct entity boxA = {.position = V2(0.0f, 0.0f), .volume = box};
+    struct entity boxB = {.position = V2(2.0f, 0.0f), .rotation = 0.5f, .volume = box};
+    EntityUpdateRotation(&boxA);
+    EntityUpdateRotation(&boxB);
+    pair_cache_entry cache = {};
+    contact contact;
+
+    b8 isSeparated = !CollisionDetect(&boxA, &boxB, &cache, &contact) && cache.hasSeparatingEdge &&
+                     !CollisionDetect(&boxA, &boxB, &cache, &contact) && cache.hasSeparatingEdge;
+
+    boxB.position = V2(0.9f, 0.0f);
+    b8 isOverlapping = CollisionDetect(&boxA, &boxB, &cache, &contact) && !cache.hasSeparatingEdge;
+
+    // full search keeps deepest vertex of B against first edge of A, as hint for next frame
+    world_polygon polygonA;
+    world_polygon polygonB;
+    EntityGetPolygon(&boxA, &polygonA);
+    EntityGetPolygon(&boxB, &polygonB);
+    b8 isHintKept = 1;
+    for (u32 vertexIndex = 0; vertexIndex < polygonB.count; vertexIndex++) {
+      if (v2_dot(polygonA.normals[0], polygonB.verticies[vertexIndex]) <
+          v2_dot(polygonA.normals[0], polygonB.verticies[cache.firstSupports[0]]))
+        isHintKept = 0;
+    }
+
+    if (!isSeparated || !isOverlapping || !isHintKept) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_SEPARATING_AXIS);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_SEPARATING_AXIS;
+    }
+  }
+
+  // b8 CollisionDetect(struct entity *a, struct entity *b, pair_cache_entry *cache, contact *contact)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *circle = VolumeCircle(tempMemory.arena, 0.5f);
+    volume *box = VolumeBox(tempMemory.arena, 1.0f, 2.0f);
+
+    // box standing on its side, circle resting on top penetrating by 0.1m
+    struct entity circleEntity = {.position = V2(0.0f, 0.9f), .volume = circle};
+    struct entity boxEntity = {.position = V2(0.0f, 0.0f), .rotation = PI / 2.0f, .volume = box};
+    EntityUpdateRotation(&boxEntity);
+    contact contact;
+    b8 isColliding = CollisionDetect(&boxEntity, &circleEntity, 0, &contact);
+
+    contact_point *point = contact.points + 0;
+    if (!isColliding || contact.pointCount != 1 || Absolute(contact.normal.x) > 0.001f ||
+        Absolute(contact.normal.y - 1.0f) > 0.001f || Absolute(point->depth - 0.1f) > 0.001f ||
+        Absolute(point->end.y - 0.5f) > 0.001f || Absolute(point->start.y - 0.4f) > 0.001f ||
+        // circle beyond corner
+        CollisionDetect(&boxEntity, &(struct entity){.position = V2(1.4f, 0.9f), .volume = circle}, 0, &contact)) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_CIRCLE_BOX);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_CIRCLE_BOX;
+    }
+  }
+
+  // b8 CollisionDetect(struct entity *a, struct entity *b, pair_cache_entry *cache, contact *contact)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *circle = VolumeCircle(tempMemory.arena, 0.5f);
+    v2 verticies[] = {V2(-1.0f, 0.0f), V2(1.0f, 0.0f), V2(0.0f, 1.0f)};
+    volume *triangle = VolumePolygon(tempMemory.arena, ARRAY_COUNT(verticies), verticies);
+
+    // verticies are relative to centroid, entity at centroid covers given verticies
+    struct entity polygonEntity = {.position = VolumeGetPolygon(triangle)->centroid, .volume = triangle};
+    EntityUpdateRotation(&polygonEntity);
+    // below bottom edge
+    struct entity circleEdge = {.position = V2(0.0f, -0.4f), .volume = circle};
+    // next to right vertex
+    struct entity circleVertex = {.position = V2(1.3f, -0.3f), .volume = circle};
+
+    contact edgeContact;
+    contact vertexContact;
+    b8 isEdgeColliding = CollisionDetect(&circleEdge, &polygonEntity, 0, &edgeContact);
+    b8 isVertexColliding = CollisionDetect(&circleVertex, &polygonEntity, 0, &vertexContact);
+
+    if (!isEdgeColliding || Absolute(edgeContact.normal.y - 1.0f) > 0.001f ||
+        Absolute(edgeContact.points[0].depth - 0.1f) > 0.001f || !isVertexColliding ||
+        Absolute(vertexContact.normal.x + 0.7071f) > 0.001f || Absolute(vertexContact.normal.y - 0.7071f) > 0.001f ||
+        v2_length_square(v2_sub(vertexContact.points[0].start, V2(1.0f, 0.0f))) > 0.0001f) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_CIRCLE_POLYGON);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_CIRCLE_POLYGON;
+    }
+  }
+
+  // u32 PolygonSupportIndex(f32 *xs, f32 *ys, u32 vertexCount, v2 direction)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+
+    // vertex count that is not multiple of SIMD width, so padding is used
+    v2 verticies[12];
+    for (u32 vertexIndex = 0; vertexIndex < ARRAY_COUNT(verticies); vertexIndex++) {
+      f32 angle = 2.0f * PI * (f32)vertexIndex / (f32)ARRAY_COUNT(verticies);
+      verticies[vertexIndex] = V2(Cos(angle), Sin(angle));
+    }
+    volume_polygon *polygon =
+        VolumeGetPolygon(VolumePolygon(tempMemory.arena, ARRAY_COUNT(verticies), verticies));
+
+    // hull starts from leftmost vertex, so compare verticies instead of indices
+    b8 isSupportCorrect = polygon->vertexCount == ARRAY_COUNT(verticies);
+    for (u32 vertexIndex = 0; vertexIndex < ARRAY_COUNT(verticies); vertexIndex++) {
+      // first vertex is also the padding
+      u32 supportIndex = PolygonSupportIndex(polygon->xs, polygon->ys, polygon->vertexCount, verticies[vertexIndex]);
+      v2 expected = v2_sub(verticies[vertexIndex], polygon->centroid);
+      if (v2_length_square(v2_sub(polygon->verticies[supportIndex], expected)) > 0.000001f)
+        isSupportCorrect = 0;
+    }
+
+    if (!isSupportCorrect) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_POLYGON_SUPPORT);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_POLYGON_SUPPORT;
+    }
+  }
+
+  // u32 PolygonSupportIndexFrom(v2 *verticies, u32 vertexCount, v2 direction, u32 hintIndex)
+  {
+    v2 verticies[100];
+    for (u32 vertexIndex = 0; vertexIndex < ARRAY_COUNT(verticies); vertexIndex++) {
+      f32 angle = 2.0f * PI * (f32)vertexIndex / (f32)ARRAY_COUNT(verticies);
+      verticies[vertexIndex] = V2(Cos(angle), Sin(angle));
+    }
+
+    b8 isSupportCorrect = 1;
+    for (u32 directionIndex = 0; directionIndex < 16; directionIndex++) {
+      f32 angle = 2.0f * PI * ((f32)directionIndex + 0.3f) / 16.0f;
+      v2 direction = V2(Cos(angle), Sin(angle));
+      for (u32 hintIndex = 0; hintIndex < ARRAY_COUNT(verticies); hintIndex += 7) {
+        u32 supportIndex = PolygonSupportIndexFrom(verticies, ARRAY_COUNT(verticies), direction, hintIndex);
+        for (u32 vertexIndex = 0; vertexIndex < ARRAY_COUNT(verticies); vertexIndex++) {
+          if (v2_dot(verticies[vertexIndex], direction) > v2_dot(verticies[supportIndex], direction))
+            isSupportCorrect = 0;
+        }
+      }
+    }
+
+    if (!isSupportCorrect) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_POLYGON_HILL_CLIMB);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_POLYGON_HILL_CLIMB;
+    }
+  }
+
+  // f32 GJKDistance(struct entity *entityA, struct entity *entityB, gjk_simplex_cache *simplex, v2 *pointA, v2 *pointB)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *box = VolumeBox(tempMemory.arena, 1.0f, 1.0f);
+    volume *circle = VolumeCircle(tempMemory.arena, 0.5f);
+
+    // boxes 2m apart, circle 2m above
+    struct entity boxA = {.position = V2(0.0f, 0.0f), .volume = box};
+    struct entity boxB = {.position = V2(3.0f, 0.0f), .volume = box};
+    struct entity circleEntity = {.position = V2(0.0f, 3.0f), .volume = circle};
+    EntityUpdateRotation(&boxA);
+    EntityUpdateRotation(&boxB);
+    gjk_simplex_cache simplex = {};
+    v2 pointA, pointB;
+
+    f32 distance = GJKDistance(&boxA, &boxB, &simplex, &pointA, &pointB);
+    // warm started from simplex of previous query
+    f32 cachedDistance = GJKDistance(&boxA, &boxB, &simplex, 0, 0);
+    f32 circleDistance = GJKDistance(&circleEntity, &boxA, 0, &pointA, &pointB);
+    b8 isCircleCorrect = Absolute(circleDistance - 2.0f) < 0.001f && Absolute(pointA.y - 2.5f) < 0.001f &&
+                         Absolute(pointB.y - 0.5f) < 0.001f;
+
+    boxB.position = V2(0.9f, 0.0f);
+    f32 overlapDistance = GJKDistance(&boxA, &boxB, &simplex, 0, 0);
+
+    if (Absolute(distance - 2.0f) > 0.001f || Absolute(cachedDistance - 2.0f) > 0.001f || !isCircleCorrect ||
+        overlapDistance != 0.0f) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_GJK_DISTANCE);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_GJK_DISTANCE;
+    }
+  }
+
+  // void EntitySolveTimeOfImpact(struct entity *entities, u32 entityCount, terrain *terrain, u32 bulletIndex,
+  //                              f32 slop)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *box = VolumeBox(tempMemory.arena, 1.0f, 1.0f);
+    volume *circle = VolumeCircle(tempMemory.arena, 0.25f);
+
+    // bullet jumps from left of box to right of it in one step
+    struct entity entities[3] = {
+        {},
+        {.position = V2(0.0f, 0.0f), .volume = box, .filter = COLLISION_FILTER_DEFAULT},
+        {.sweepPosition = V2(-5.0f, 0.0f),
+         .position = V2(5.0f, 0.0f),
+         .invMass = 1.0f,
+         .isBullet = 1,
+         .volume = circle,
+         .filter = COLLISION_FILTER_DEFAULT},
+    };
+    EntityUpdateRotation(entities + 1);
+    EntityUpdateRotation(entities + 2);
+    f32 slop = 0.005f;
+
+    // touches box after moving 4.25m of 10m
+    f32 t = TimeOfImpact(entities + 2, entities + 1, slop);
+    EntitySolveTimeOfImpact(entities, ARRAY_COUNT(entities), 0, 2, slop);
+    b8 isStopped = Absolute(entities[2].position.x - (-0.75f + slop)) < 0.001f;
+
+    // passing above box is not touched
+    entities[2].sweepPosition = V2(-5.0f, 1.0f);
+    entities[2].position = V2(5.0f, 1.0f);
+    EntitySolveTimeOfImpact(entities, ARRAY_COUNT(entities), 0, 2, slop);
+    b8 isPassing = entities[2].position.x == 5.0f;
+
+    // thin terrain wall is hit the same way
+    v2 wall[] = {V2(0.0f, 4.0f), V2(0.2f, 4.0f), V2(0.1f, 6.0f)};
+    terrain terrain;
+    TerrainInit(&terrain, tempMemory.arena, 1, wall, 1.0f);
+    entities[2].sweepPosition = V2(-5.0f, 5.0f);
+    entities[2].position = V2(5.0f, 5.0f);
+    EntitySolveTimeOfImpact(entities, ARRAY_COUNT(entities), &terrain, 2, slop);
+    b8 isStoppedByTerrain = Absolute(entities[2].position.x - (-0.2f + slop)) < 0.001f;
+
+    if (Absolute(t - 0.425f) > 0.001f || !isStopped || !isPassing || !isStoppedByTerrain) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_TIME_OF_IMPACT);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_TIME_OF_IMPACT;
+    }
+  }
+
+  // u32 NarrowphaseCircles(circle_pack *circles, collision_pair *pairs, u32 startIndex, u32 endIndex,
+  //                        collision *collisions)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    volume *circle = VolumeCircle(tempMemory.arena, 0.5f);
+    volume *box = VolumeBox(tempMemory.arena, 1.0f, 1.0f);
+
+    // row of circles, every third one overlapping its neighbour, box at end
+    struct entity entities[22] = {};
+    u32 entityCount = ARRAY_COUNT(entities);
+    for (u32 entityIndex = 1; entityIndex < entityCount; entityIndex++) {
+      struct entity *entity = entities + entityIndex;
+      entity->position = V2((f32)entityIndex * 1.2f - (entityIndex % 3 == 0 ? 0.5f : 0.0f), 0.0f);
+      entity->volume = entityIndex == entityCount - 1 ? box : circle;
+      EntityUpdateRotation(entity);
+    }
+
+    // every pair is candidate
+    u32 pairCount = 0;
+    collision_pair pairs[22 * 21 / 2];
+    for (u32 a = 1; a < entityCount; a++) {
+      for (u32 b = a + 1; b < entityCount; b++) {
+        pairs[pairCount] = (collision_pair){.entityAIndex = a, .entityBIndex = b};
+        pairCount++;
+      }
+    }
+
+    u32 circlePairCount = BroadphaseBucketPairs(tempMemory.arena, entities, pairs, pairCount);
+    circle_pack circles = CirclePack(tempMemory.arena, entities, entityCount);
+    collision batched[ARRAY_COUNT(pairs)];
+    collision generic[ARRAY_COUNT(pairs)];
+    u32 batchedCount = NarrowphaseCircles(&circles, pairs, 0, circlePairCount, batched);
+    u32 genericCount = Narrowphase(entities, pairs, 0, circlePairCount, generic);
+
+    b8 isMatching = batchedCount == genericCount && batchedCount > 0 && circlePairCount == 20 * 19 / 2;
+    for (u32 collisionIndex = 0; isMatching && collisionIndex < batchedCount; collisionIndex++) {
+      collision *a = batched + collisionIndex;
+      collision *b = generic + collisionIndex;
+      isMatching = a->pairIndex == b->pairIndex &&
+                   Absolute(a->contact.points[0].depth - b->contact.points[0].depth) < 0.0001f &&
+                   a->contact.normal.x == b->contact.normal.x;
+    }
+
+    if (!isMatching) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_NARROWPHASE_CIRCLES);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_NARROWPHASE_CIRCLES;
+    }
+  }
+
+  // b8 ShouldEntitiesCollide(struct entity *entityA, struct entity *entityB)
+  {
+    struct entity player = {.invMass = 1.0f, .filter = {.categoryBits = 1 << 0, .maskBits = U32_MAX}};
+    struct entity ghost = {.invMass = 1.0f, .filter = {.categoryBits = 1 << 1, .maskBits = ~(1u << 0)}};
+    struct entity wall = {.filter = {.categoryBits = 1 << 3, .maskBits = U32_MAX}};
+    struct entity prop = {.filter = COLLISION_FILTER_DEFAULT};
+    // ragdoll parts do not collide with each other, but with everything else
+    struct entity arm = {.invMass = 1.0f, .filter = {.categoryBits = 1, .maskBits = U32_MAX, .group = -1}};
+    struct entity leg = {.invMass = 1.0f, .filter = {.categoryBits = 1, .maskBits = U32_MAX, .group = -1}};
+    // positive group wins over mask
+    struct entity magnetA = {.invMass = 1.0f, .filter = {.categoryBits = 1 << 2, .maskBits = 0, .group = 2}};
+    struct entity magnetB = {.invMass = 1.0f, .filter = {.categoryBits = 1 << 2, .maskBits = 0, .group = 2}};
+
+    if (!ShouldEntitiesCollide(&player, &wall) || ShouldEntitiesCollide(&player, &ghost) ||
+        !ShouldEntitiesCollide(&ghost, &wall) || ShouldEntitiesCollide(&wall, &prop) ||
+        ShouldEntitiesCollide(&arm, &leg) || !ShouldEntitiesCollide(&arm, &player) ||
+        !ShouldEntitiesCollide(&magnetA, &magnetB) || ShouldEntitiesCollide(&magnetA, &player)) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_COLLISION_FILTER);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_COLLISION_FILTER;
+    }
+  }
+
+  // u32 PairRuleRemoveEntity(pair_rule_table *table, u32 entityIndex)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    pair_rule_table rules;
+    PairRuleTableInit(&rules, tempMemory.arena, 8);
+
+    // entity 1 is jointed to 2..7, table is nearly full so probe chains overlap
+    for (u32 entityIndex = 2; entityIndex < 8; entityIndex++)
+      PairRuleSet(&rules, entityIndex, 1)->flags = PAIR_RULE_IGNORE;
+    PairRuleSet(&rules, 2, 3)->flags = PAIR_RULE_RESTITUTION;
+    PairRuleSet(&rules, 4, 5)->flags = PAIR_RULE_RESTITUTION;
+
+    b8 isFound =
+        rules.count == 8 && PairRuleGet(&rules, 1, 7) && PairRuleGet(&rules, 7, 1) && !PairRuleGet(&rules, 3, 4);
+    b8 isPairRemoved = PairRuleRemove(&rules, 4, 5) && !PairRuleGet(&rules, 4, 5) && !PairRuleRemove(&rules, 4, 5);
+    u32 removedCount = PairRuleRemoveEntity(&rules, 1);
+    b8 isEntityRemoved = removedCount == 6 && rules.count == 1 && !PairRuleGet(&rules, 1, 2) &&
+                         !PairRuleGet(&rules, 1, 7) && PairRuleGet(&rules, 3, 2)->flags == PAIR_RULE_RESTITUTION;
+
+    if (!isFound || !isPairRemoved || !isEntityRemoved) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_PAIR_RULE);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_PAIR_RULE;
+    }
+  }
+
+  // volume *VolumePolygon(memory_arena *memory, u32 vertexCount, v2 verticies[static vertexCount])
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    // 2x2 square away from origin, same inertia as box
+    v2 square[] = {V2(1.0f, 1.0f), V2(3.0f, 1.0f), V2(3.0f, 3.0f), V2(1.0f, 3.0f)};
+    volume *squareVolume = VolumePolygon(tempMemory.arena, ARRAY_COUNT(square), square);
+    volume_polygon *squarePolygon = VolumeGetPolygon(squareVolume);
+    f32 boxInertia = VolumeGetMomentOfInertia(VolumeBox(tempMemory.arena, 2.0f, 2.0f), 3.0f);
+    f32 squareInertia = VolumeGetMomentOfInertia(squareVolume, 3.0f);
+    // right triangle with legs of 3m, centroid at third of legs
+    v2 triangle[] = {V2(0.0f, 0.0f), V2(3.0f, 0.0f), V2(0.0f, 3.0f)};
+    volume_polygon *trianglePolygon =
+        VolumeGetPolygon(VolumePolygon(tempMemory.arena, ARRAY_COUNT(triangle), triangle));
+
+    if (Absolute(squarePolygon->area - 4.0f) > 0.001f || Absolute(squarePolygon->centroid.x - 2.0f) > 0.001f ||
+        Absolute(squarePolygon->centroid.y - 2.0f) > 0.001f ||
+        v2_length_square(v2_sub(squarePolygon->verticies[0], V2(-1.0f, -1.0f))) > 0.0001f ||
+        Absolute(squareInertia - boxInertia) > 0.001f || Absolute(trianglePolygon->area - 4.5f) > 0.001f ||
+        Absolute(trianglePolygon->centroid.x - 1.0f) > 0.001f ||
+        Absolute(trianglePolygon->centroid.y - 1.0f) > 0.001f) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_POLYGON_MASS);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_POLYGON_MASS;
+    }
+  }
+
+  // volume *VolumeTriangle(memory_arena *memory, v2 a, v2 b, v2 c)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    v2 verticies[] = {V2(-1.0f, 0.0f), V2(1.0f, 0.0f), V2(0.0f, 1.0f)};
+    u64 usedBefore = tempMemory.arena->used;
+    volume *triangle = VolumeTriangle(tempMemory.arena, verticies[0], verticies[1], verticies[2]);
+    b8 isInline = tempMemory.arena->used - usedBefore <= sizeof(volume) + sizeof(volume_triangle) + sizeof(void *);
+    volume *polygon = VolumePolygon(tempMemory.arena, ARRAY_COUNT(verticies), verticies);
+    volume *box = VolumeBox(tempMemory.arena, 1.0f, 1.0f);
+    volume *circle = VolumeCircle(tempMemory.arena, 0.5f);
+
+    v2 centroid = VolumeGetTriangle(triangle)->centroid;
+    struct entity triangleEntity = {.position = centroid, .volume = triangle};
+    struct entity polygonEntity = {.position = centroid, .volume = polygon};
+    // box sinking into slanted edge, circle sinking into bottom edge
+    struct entity boxEntity = {.position = V2(0.8f, 0.8f), .volume = box};
+    struct entity circleEntity = {.position = V2(0.0f, -0.4f), .volume = circle};
+    EntityUpdateRotation(&triangleEntity);
+    EntityUpdateRotation(&polygonEntity);
+    EntityUpdateRotation(&boxEntity);
+
+    contact triangleBox, polygonBox, triangleCircle, polygonCircle;
+    b8 isBoxColliding = CollisionDetect(&triangleEntity, &boxEntity, 0, &triangleBox) &&
+                        CollisionDetect(&polygonEntity, &boxEntity, 0, &polygonBox);
+    b8 isCircleColliding = CollisionDetect(&circleEntity, &triangleEntity, 0, &triangleCircle) &&
+                           CollisionDetect(&circleEntity, &polygonEntity, 0, &polygonCircle);
+    b8 isMatching = isBoxColliding && isCircleColliding && triangleBox.pointCount == polygonBox.pointCount &&
+                    Absolute(triangleBox.points[0].depth - polygonBox.points[0].depth) < 0.0001f &&
+                    Absolute(triangleCircle.points[0].depth - polygonCircle.points[0].depth) < 0.0001f &&
+                    Absolute(triangleCircle.points[0].depth - 0.1f) < 0.001f;
+    b8 isMassMatching = VolumeGetMomentOfInertia(triangle, 2.0f) == VolumeGetMomentOfInertia(polygon, 2.0f) &&
+                        VolumeGetBoundingRadius(triangle) == VolumeGetBoundingRadius(polygon);
+
+    if (!isInline || !isMatching || !isMassMatching) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_TRIANGLE);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_TRIANGLE;
+    }
+  }
+
+  // u32 ConvexHull(u32 vertexCount, v2 *verticies, v2 *hull)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    // clockwise square with inside vertex, vertex on edge and almost duplicate corner
+    v2 verticies[] = {
+        V2(0.0f, 0.0f), V2(0.0f, 2.0f),    V2(1.0f, 1.0f), V2(2.0f, 2.0f),
+        V2(2.0f, 1.0f), V2(2.001f, 2.0f), V2(2.0f, 0.0f),
+    };
+    volume *square = VolumePolygon(tempMemory.arena, ARRAY_COUNT(verticies), verticies);
+    volume_polygon *polygon = square ? VolumeGetPolygon(square) : 0;
+
+    b8 isHull = polygon && polygon->vertexCount == 4 && Absolute(polygon->area - 4.0f) < 0.01f;
+    for (u32 vertexIndex = 0; isHull && vertexIndex < polygon->vertexCount; vertexIndex++) {
+      v2 edge = v2_sub(polygon->verticies[(vertexIndex + 1) % 4], polygon->verticies[vertexIndex]);
+      v2 nextEdge = v2_sub(polygon->verticies[(vertexIndex + 2) % 4], polygon->verticies[(vertexIndex + 1) % 4]);
+      // counter clockwise
+      isHull = v2_cross(edge, nextEdge) > 0.0f;
+    }
+
+    v2 line[] = {V2(0.0f, 0.0f), V2(1.0f, 0.0f), V2(2.0f, 0.001f), V2(3.0f, 0.0f)};
+    v2 duplicates[] = {V2(1.0f, 1.0f), V2(1.0f, 1.0f), V2(1.001f, 1.0f)};
+    b8 isDegenerateRejected = VolumePolygon(tempMemory.arena, ARRAY_COUNT(line), line) == 0 &&
+                              VolumePolygon(tempMemory.arena, ARRAY_COUNT(duplicates), duplicates) == 0 &&
+                              VolumeTriangle(tempMemory.arena, line[0], line[1], line[3]) == 0;
+
+    // valid square, but given with more verticies than fit
+    v2 corners[] = {V2(0.0f, 0.0f), V2(2.0f, 0.0f), V2(2.0f, 2.0f), V2(0.0f, 2.0f)};
+    v2 tooMany[VOLUME_POLYGON_VERTEX_MAX + 1];
+    for (u32 vertexIndex = 0; vertexIndex < ARRAY_COUNT(tooMany); vertexIndex++)
+      tooMany[vertexIndex] = corners[vertexIndex % ARRAY_COUNT(corners)];
+    b8 isTooManyRejected = VolumePolygon(tempMemory.arena, ARRAY_COUNT(tooMany), tooMany) == 0 &&
+                           VolumePolygon(tempMemory.arena, VOLUME_POLYGON_VERTEX_MAX, tooMany) != 0;
+
+    if (!isHull || !isDegenerateRejected || !isTooManyRejected) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_CONVEX_HULL);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_CONVEX_HULL;
+    }
+  }
+
+  // terrain_pair *TerrainBroadphase(memory_arena *memory, terrain *terrain, struct entity *entities,
+  //                                 u32 entityCount, u32 *pairCount)
+  // u32 TerrainNarrowphase(terrain *terrain, struct entity *entities, terrain_pair *pairs, u32 startIndex,
+  //                        u32 endIndex, collision *collisions)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+
+    // ground from x -10 to 10, top at y 0, two triangles per meter
+    const u32 quadCount = 20;
+    v2 *verticies = MemoryArenaPush(tempMemory.arena, sizeof(*verticies) * quadCount * 6);
+    for (u32 quadIndex = 0; quadIndex < quadCount; quadIndex++) {
+      f32 left = -10.0f + (f32)quadIndex;
+      f32 right = left + 1.0f;
+      v2 *quad = verticies + quadIndex * 6;
+      quad[0] = V2(left, -1.0f), quad[1] = V2(right, -1.0f), quad[2] = V2(right, 0.0f);
+      quad[3] = V2(left, -1.0f), quad[4] = V2(right, 0.0f), quad[5] = V2(left, 0.0f);
+    }
+    terrain terrain;
+    TerrainInit(&terrain, tempMemory.arena, quadCount * 2, verticies, 2.0f);
+
+    volume *box = VolumeBox(tempMemory.arena, 1.0f, 1.0f);
+    volume *circle = VolumeCircle(tempMemory.arena, 0.25f);
+    // index 0 is null entity, static body of terrain contacts
+    struct entity entities[5] = {};
+    // sinks 0.1 into ground, bounds straddle cells
+    entities[1] = (struct entity){.position = V2(0.3f, 0.4f), .volume = box, .invMass = 1.0f};
+    // above ground
+    entities[2] = (struct entity){.position = V2(3.0f, 5.0f), .volume = circle, .invMass = 1.0f};
+    // on ground but sleeping
+    entities[3] = (struct entity){.position = V2(5.0f, 0.2f), .volume = circle, .invMass = 1.0f, .isSleeping = 1};
+    // on ground but filtered out
+    entities[4] = (struct entity){.position = V2(-5.0f, 0.2f), .volume = circle, .invMass = 1.0f};
+    for (u32 entityIndex = 1; entityIndex < ARRAY_COUNT(entities); entityIndex++) {
+      entities[entityIndex].filter = COLLISION_FILTER_DEFAULT;
+      EntityUpdateRotation(entities + entityIndex);
+    }
+    entities[4].filter.maskBits = ~terrain.filter.categoryBits;
+
+    u32 pairCount;
+    terrain_pair *pairs = TerrainBroadphase(tempMemory.arena, &terrain, entities, ARRAY_COUNT(entities), &pairCount);
+
+    // every triangle overlapping box's bounds exactly once, nothing else
+    rect boxBound = EntityGetBoundingRect(entities + 1);
+    u32 expectedCount = 0;
+    for (u32 triangleIndex = 0; triangleIndex < terrain.triangleCount; triangleIndex++)
+      expectedCount += IsAABBOverlapping(boxBound, terrain.bounds[triangleIndex]);
+
+    b8 isPairsCorrect = terrain.triangleCount == quadCount * 2 && pairCount == expectedCount && pairCount > 0;
+    for (u32 pairIndex = 0; isPairsCorrect && pairIndex < pairCount; pairIndex++) {
+      terrain_pair *pair = pairs + pairIndex;
+      isPairsCorrect = pair->entityIndex == 1 && IsAABBOverlapping(boxBound, terrain.bounds[pair->triangleIndex]);
+      for (u32 otherIndex = 0; isPairsCorrect && otherIndex < pairIndex; otherIndex++)
+        isPairsCorrect = pairs[otherIndex].triangleIndex != pair->triangleIndex;
+    }
+
+    collision *collisions = MemoryArenaPush(tempMemory.arena, sizeof(*collisions) * pairCount);
+    u32 collisionCount = isPairsCorrect ? TerrainNarrowphase(&terrain, entities, pairs, 0, pairCount, collisions) : 0;
+    b8 isCollisionsCorrect = collisionCount > 0;
+    for (u32 collisionIndex = 0; isCollisionsCorrect && collisionIndex < collisionCount; collisionIndex++) {
+      collision *collision = collisions + collisionIndex;
+      // pushes box up, out of ground
+      isCollisionsCorrect = collision->entityAIndex == TERRAIN_ENTITY_INDEX && collision->entityBIndex == 1 &&
+                            collision->contact.normal.y > 0.99f &&
+                            Absolute(collision->contact.points[0].depth - 0.1f) < 0.001f;
+    }
+
+    if (!isPairsCorrect || !isCollisionsCorrect) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_TERRAIN);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_TERRAIN;
+    }
+  }
+
+  // pair_cache_entry *PairCacheInsert(pair_cache *cache, u32 entityAIndex, u32 entityBIndex)
+  {
+    __cleanup_memory_temp__ memory_temp tempMemory = MemoryTempBegin(&stackMemory);
+    pair_cache cache;
+    PairCacheInit(&cache, tempMemory.arena, 8);
+
+    PairCacheSwap(&cache);
+    pair_cache_entry *kept = PairCacheInsert(&cache, 1, 2);
+    pair_cache_entry *dropped = PairCacheInsert(&cache, 3, 4);
+    kept->normalImpulses[0] = 2.0f;
+    dropped->normalImpulses[0] = 3.0f;
+
+    // next frame, only pair {1, 2} overlaps
+    PairCacheSwap(&cache);
+    kept = PairCacheInsert(&cache, 1, 2);
+    b8 isKept = kept && kept->normalImpulses[0] == 2.0f && PairCacheInsert(&cache, 1, 2) == kept;
+
+    // pair {3, 4} overlaps again, but was not seen in previous frame, its stale entry is cleared
+    PairCacheSwap(&cache);
+    dropped = PairCacheInsert(&cache, 3, 4);
+
+    // full cache rejects new pairs, but still finds ones it holds
+    PairCacheSwap(&cache);
+    b8 isFullRejected = 1;
+    for (u32 pairIndex = 0; pairIndex < cache.pairMax; pairIndex++)
+      isFullRejected = isFullRejected && PairCacheInsert(&cache, 1, 2 + pairIndex);
+    isFullRejected = isFullRejected && !PairCacheInsert(&cache, 1, 2 + cache.pairMax) &&
+                     !PairCacheInsertTerrain(&cache, 0, 1) && PairCacheInsert(&cache, 1, 2);
+
+    if (!isKept || !dropped || dropped->normalImpulses[0] != 0.0f ||
+        cache.filledCounts[cache.tableIndex ^ 1] != 1 || !isFullRejected) {
+      StringBuilderAppendTestError(sb, PHYSICS_TEST_ERROR_PAIRCACHE);
+      StringBuilderAppendStringLiteral(sb, "\n");
+      string message = StringBuilderFlush(sb);
+      LogMessage(&message);
+
+      errorCode = PHYSICS_TEST_ERROR_PAIRCACHE;
+    }
+  }
+
   return (int)errorCode;
 }